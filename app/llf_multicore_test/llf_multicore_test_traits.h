@@ -120,6 +120,7 @@ template<> struct Traits<Thread>: public Traits<Build>
     static const int priority_inversion_protocol = NONE;
 
     typedef LLF Criterion;
+    static const int scheduling_queue = Scheduling_Queue_Backend::ORDERED_LIST;
     static const unsigned int QUANTUM = 10000; // us
 };
 
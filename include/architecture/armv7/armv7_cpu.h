@@ -77,6 +77,9 @@ public:
 
     static void halt() { ASM("wfi"); }
 
+    // Full memory barrier: no load or store is reordered across it (as seen by the other cores)
+    static void fence() { ASM("dmb" : : : "memory"); }
+
     template<typename T>
     static T tsl(volatile T & lock) {
         register T old;
@@ -455,6 +458,7 @@ public:
     static bool int_disabled() { return psr() & (FLAG_F | FLAG_I); }
 
     using ARMv7::halt;
+    using ARMv7::fence;
 
     static unsigned int id() { return 0; }
     static unsigned int cores() { return 1; }
@@ -649,6 +653,7 @@ public:
     using Base::int_disabled;
 
     using Base::halt;
+    using Base::fence;
 
     using Base::fpu_save;
     using Base::fpu_restore;
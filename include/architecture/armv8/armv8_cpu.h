@@ -290,6 +290,9 @@ public:
 
     using ARMv7_A::halt;
 
+    // Full memory barrier: no load or store is reordered across it (as seen by the other cores in the inner shareable domain)
+    static void fence() { ASM("dmb ish" : : : "memory"); }
+
     static unsigned int id() { return 0; }
     static unsigned int cores() { return 1; }
 
@@ -544,6 +547,7 @@ public:
     using Base::int_disabled;
 
     using Base::halt;
+    using Base::fence;
 
     using Base::fpu_save;
     using Base::fpu_restore;
@@ -377,6 +377,9 @@ public:
 
     static void halt() { ASM("hlt"); }
 
+    // Full memory barrier: no load or store is reordered across it (as seen by the other cores)
+    static void fence() { ASM("mfence" : : : "memory"); }
+
     static void fpu_save() {} // TODO
     static void fpu_restore() {} // TODO
 
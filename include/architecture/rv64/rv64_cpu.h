@@ -246,6 +246,9 @@ public:
 
     static void halt() { ASM("wfi"); }
 
+    // Full memory barrier: no load or store is reordered across it (as seen by the other harts)
+    static void fence() { ASM("fence rw, rw" : : : "memory"); }
+
     static void fpu_save();
     static void fpu_restore();
 
@@ -54,6 +54,7 @@ public:
 public:
     static Reg64 mtime() { return *reinterpret_cast<Reg64 *>(Memory_Map::CLINT_BASE + MTIME); }
     static void  mtimecmp(Reg64 v) { *reinterpret_cast<Reg64 *>(Memory_Map::CLINT_BASE + MTIMECMP + 8 * (CPU::id() + CPU_OFFSET)) = v; }
+    static void  mtimecmp(unsigned int cpu, Reg64 v) { *reinterpret_cast<volatile Reg64 *>(Memory_Map::CLINT_BASE + MTIMECMP + 8 * (cpu + CPU_OFFSET)) = v; }
 
     static volatile Reg32 & msip(unsigned int cpu) { return *reinterpret_cast<volatile Reg32 *>(Memory_Map::CLINT_BASE + MSIP + 4 * (cpu + CPU_OFFSET)); }
 };
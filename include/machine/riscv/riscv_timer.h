@@ -8,6 +8,7 @@
 #include <machine/timer.h>
 #include <system/memory_map.h>
 #include <utility/convert.h>
+#include <utility/spin.h>
 
 __BEGIN_SYS
 
@@ -24,6 +25,9 @@ protected:
     static const Hertz FREQUENCY = Traits<Timer>::FREQUENCY;
 
     typedef IC_Common::Interrupt_Id Interrupt_Id;
+    typedef CPU::Reg64 Time_Stamp;
+
+    static const Time_Stamp DISARMED = -1ULL;
 
 public:
     using Timer_Common::Tick;
@@ -37,18 +41,30 @@ public:
 
     static const Hertz CLOCK = Traits<Timer>::CLOCK;
 
+    // In tickless mode, each channel keeps an absolute deadline (in mtime counts) per CPU and each CPU's
+    // mtimecmp is programmed for the earliest of them. Retriggering channels are rearmed one period after
+    // they expire, while the others are one-shot and must be rearmed with restart() or program().
+    // Channels can then run at any frequency up to CLOCK, since they no longer count FREQUENCY ticks.
+    static const bool tickless = Traits<Timer>::tickless;
+
 protected:
-    Timer(unsigned int channel, const Hertz & frequency, const Handler & handler, bool retrigger = true)
-    : _channel(channel), _initial(FREQUENCY / frequency), _retrigger(retrigger), _handler(handler) {
+    // Periodic channels other than SCHEDULER are only handled by CPU 0, unless they are "per_cpu"
+    Timer(unsigned int channel, const Hertz & frequency, const Handler & handler, bool retrigger = true, bool per_cpu = false)
+    : _channel(channel), _initial(FREQUENCY / frequency), _retrigger(retrigger), _per_cpu(per_cpu), _handler(handler), _period(CLOCK / frequency) {
         db<Timer>(TRC) << "Timer(f=" << frequency << ",h=" << reinterpret_cast<void*>(handler) << ",ch=" << channel << ") => {count=" << _initial << "}" << endl;
 
-        if(_initial && (channel < CHANNELS) && !_channels[channel])
+        if((tickless ? _period : _initial) && (channel < CHANNELS) && !_channels[channel])
             _channels[channel] = this;
         else
             db<Timer>(WRN) << "Timer not installed!"<< endl;
 
-        for(unsigned int i = 0; i < Traits<Machine>::CPUS; i++)
+        for(unsigned int i = 0; i < Traits<Machine>::CPUS; i++) {
             _current[i] = _initial;
+            _deadline[i] = retrigger ? mtime() + _period : DISARMED;
+        }
+
+        if(tickless)
+            reprogram(CPU::id());
     }
 
 public:
@@ -56,31 +72,111 @@ public:
         db<Timer>(TRC) << "~Timer(f=" << frequency() << ",h=" << reinterpret_cast<void*>(_handler) << ",ch=" << _channel << ") => {count=" << _initial << "}" << endl;
 
         _channels[_channel] = 0;
+
+        if(tickless)
+            reprogram(CPU::id());
     }
 
-    Tick read() { return _current[CPU::id()]; }
+    Tick read() {
+        if(!tickless)
+            return _current[CPU::id()];
 
-    int restart() {
-        db<Timer>(TRC) << "Timer::restart() => {f=" << frequency() << ",h=" << reinterpret_cast<void *>(_handler) << ",count=" << _current[CPU::id()] << "}" << endl;
+        Time_Stamp now = mtime();
+        Time_Stamp deadline = _deadline[CPU::id()];
+        return ((deadline != DISARMED) && (deadline > now)) ? (deadline - now) * FREQUENCY / CLOCK : 0;
+    }
 
-        int percentage = _current[CPU::id()] * 100 / _initial;
-        _current[CPU::id()] = _initial; 
+    int restart() {
+        db<Timer>(TRC) << "Timer::restart() => {f=" << frequency() << ",h=" << reinterpret_cast<void *>(_handler) << ",count=" << read() << "}" << endl;
+
+        int percentage;
+        if(tickless) {
+            unsigned int cpu = CPU::id();
+            Time_Stamp now = mtime();
+            percentage = (_deadline[cpu] == DISARMED) ? 100 : (_deadline[cpu] > now) ? (_deadline[cpu] - now) * 100 / _period : 0;
+            arm(cpu, now + _period);
+        } else {
+            percentage = _current[CPU::id()] * 100 / _initial;
+            _current[CPU::id()] = _initial;
+        }
 
         return percentage;
     }
 
-    static void reset() { config(FREQUENCY); }
+    // Restarts the channel on the current CPU so it expires after "limit" or after a period, whichever comes first
+    void restart(const Microsecond & limit) {
+        db<Timer>(TRC) << "Timer::restart(l=" << limit << ") => {f=" << frequency() << ",h=" << reinterpret_cast<void *>(_handler) << "}" << endl;
+
+        if(tickless) {
+            Time_Stamp count = Convert::us2count<Time_Stamp, Microsecond>(CLOCK, limit);
+            arm(CPU::id(), mtime() + ((count < _period) ? count : _period));
+        } else {
+            Tick ticks = Convert::us2count<Time_Stamp, Microsecond>(FREQUENCY, limit);
+            _current[CPU::id()] = (ticks < 1) ? 1 : (ticks < _initial) ? ticks : _initial;
+        }
+    }
+
+    // One-shot expiration when elapsed() reaches "ticks" (tickless mode only)
+    void program(const Tick & ticks, unsigned int cpu = CPU::id()) {
+        if(tickless)
+            arm(cpu, ticks * _period);
+    }
+
+    // Disarms the channel on "cpu" until the next restart() or program() (tickless mode only)
+    void stop(unsigned int cpu = CPU::id()) {
+        if(tickless)
+            arm(cpu, DISARMED);
+    }
+
+    // Periods of this channel elapsed since mtime was reset, at the resolution of the CLINT (tickless mode only).
+    // For channels running at CLOCK, these are plain mtime values.
+    Tick elapsed() const { return mtime() / _period; }
+
+    static void reset() {
+        if(!tickless)
+            config(FREQUENCY);
+        else {
+            // MIP.MTI only clears when mtimecmp is moved beyond mtime. If a deadline is already due, int_handler()
+            // will reprogram the CLINT after handling it, so we just push the next interrupt a FREQUENCY tick away.
+            Time_Stamp now = mtime();
+            Time_Stamp next = earliest(CPU::id());
+            mtimecmp((next > now) ? next : now + (CLOCK / FREQUENCY));
+        }
+    }
     static void enable() {}
     static void disable() {}
 
-    Hertz frequency() const { return (FREQUENCY / _initial); }
-    void frequency(Hertz f) { _initial = FREQUENCY / f; reset(); }
+    Hertz frequency() const { return tickless ? (CLOCK / _period) : (FREQUENCY / _initial); }
+    void frequency(Hertz f) { _initial = FREQUENCY / f; _period = CLOCK / f; reset(); }
 
     void handler(const Handler & handler) { _handler = handler; }
 
 private:
     static void config(const Hertz & frequency) { mtimecmp(mtime() + (CLOCK / frequency)); }
 
+    void arm(unsigned int cpu, const Time_Stamp & deadline) {
+        _lock[cpu].acquire();
+        _deadline[cpu] = deadline;
+        update(cpu);
+        _lock[cpu].release();
+    }
+
+    static Time_Stamp earliest(unsigned int cpu) {
+        Time_Stamp next = DISARMED;
+        for(unsigned int i = 0; i < CHANNELS; i++)
+            if(_channels[i] && (_channels[i]->_deadline[cpu] < next))
+                next = _channels[i]->_deadline[cpu];
+        return next;
+    }
+
+    static void update(unsigned int cpu) { mtimecmp(cpu, earliest(cpu)); }
+
+    static void reprogram(unsigned int cpu) {
+        _lock[cpu].acquire();
+        update(cpu);
+        _lock[cpu].release();
+    }
+
     static void int_handler(Interrupt_Id i);
 
     static void init();
@@ -89,10 +185,14 @@ protected:
     unsigned int _channel;
     Tick _initial;
     bool _retrigger;
+    bool _per_cpu;
     volatile Tick _current[Traits<Machine>::CPUS];
     Handler _handler;
+    Time_Stamp _period;
+    volatile Time_Stamp _deadline[Traits<Machine>::CPUS];
 
     static Timer * _channels[CHANNELS];
+    static Simple_Spin _lock[Traits<Machine>::CPUS];       // serialize the programming of each CPU's mtimecmp
 };
 
 // Timer used by Thread::Scheduler
@@ -106,7 +206,7 @@ public:
 class Alarm_Timer: public Timer
 {
 public:
-    Alarm_Timer(const Handler & handler): Timer(ALARM, FREQUENCY, handler) {}
+    Alarm_Timer(const Handler & handler, const Hertz & frequency = FREQUENCY, bool per_cpu = false): Timer(ALARM, frequency, handler, !tickless, per_cpu) {}
 };
 
 __END_SYS
@@ -98,6 +98,12 @@ template <> struct Traits<Timer>: public Traits<Machine_Common>
     // The choice must respect the scheduler time-slice, i. e., it must be higher
     // than the scheduler invocation frequency.
     static const long FREQUENCY = 100; // Hz
+
+    // In tickless mode, the CLINT is programmed in one-shot fashion for the earliest pending event on each hart (the next
+    // alarm, the end of the running thread's quantum, or an LLF laxity crossing) instead of interrupting at FREQUENCY.
+    // Timer::reset() reads the channels' deadlines, so it requires the kernel to run in machine mode (supervisor = false).
+    // Applications enable it by declaring "tickless = true" in their Traits<Build>.
+    static const bool tickless = Traits<Build>::tickless;
 };
 
 template <> struct Traits<UART>: public Traits<Machine_Common>
@@ -7,27 +7,34 @@
 #include <machine.h>
 #include <utility/queue.h>
 #include <utility/handler.h>
+#include <utility/pool.h>
 #include <scheduler.h>
 
 extern "C" {
     void __exit();
     void _lock_heap();
     void _unlock_heap();
+    unsigned int _lock_heap_cache();
+    void _unlock_heap_cache(unsigned int cpu);
 }
 
 __BEGIN_SYS
 
+class Synchronizer_Common;
+
 class Thread
 {
     friend class Init_End;              // context->load()
     friend class Init_System;           // for init() on CPU != 0
     friend class Scheduler<Thread>;     // for link()
-    friend class Synchronizer_Common;   // for lock() and sleep()
-    friend class Alarm;                 // for lock()
+    friend class Synchronizer_Common;   // for lock(), sleep(), and ownerships
+    friend class Alarm;                 // for lock(), sleep(), and wakeup()
     friend class System;                // for init()
     friend class IC;                    // for link() for priority ceiling
     friend void ::_lock_heap();         // for lock()
     friend void ::_unlock_heap();       // for unlock()
+    friend unsigned int ::_lock_heap_cache();           // for lock()
+    friend void ::_unlock_heap_cache(unsigned int);     // for unlock()
 
 protected:
     static const bool preemptive = Traits<Thread>::Criterion::preemptive;
@@ -64,7 +71,45 @@ public:
     };
 
     // Thread Queue
-    typedef Ordered_Queue<Thread, Criterion, Scheduler<Thread>::Element> Queue;
+    // Threads waiting on a synchronizer are kept in a Queue, which also carries the lock that guards it
+    class Queue: public Ordered_Queue<Thread, Criterion, Scheduler<Thread>::Element>
+    {
+    public:
+        // Synchronizers with more than one waiting queue have all of them guarded by the same lock (i.e. "guard")
+        Queue(Synchronizer_Common * s = 0, Spin * guard = 0): _guard(guard ? guard : &_lock), _synchronizer(s) {}
+
+        Spin * lock() { return _guard; }
+
+        // The synchronizer the queue belongs to, if any (to pass priority boosts along chains of owners)
+        Synchronizer_Common * synchronizer() const { return _synchronizer; }
+
+    private:
+        Spin _lock;
+        Spin * _guard;
+        Synchronizer_Common * _synchronizer;
+    };
+
+    // Synchronizer Ownership (for priority inversion protocols)
+    // A thread owns a synchronizer from a successful p() or lock() until the matching v() or unlock(). Each
+    // synchronizer a thread owns is recorded in one of the thread's Ownerships, linked both in the thread's
+    // _owned list and in the synchronizer's list of owners, so neither side is ever searched beyond what it
+    // actually holds. A thread can own up to OWNERSHIPS (Traits<Synchronizer>::ownerships) synchronizers at once;
+    // the excess is not tracked, so the protocol is not applied to them (a warning is issued when that happens).
+    struct Ownership {
+        typedef List_Elements::Doubly_Linked<Ownership> Element;
+
+        Ownership(): owner(0), synchronizer(0), count(0), inherited(Criterion::IDLE), by_owner(this), by_synchronizer(this) {}
+
+        Thread * owner;
+        Synchronizer_Common * volatile synchronizer;    // 0 once the synchronizer is destroyed
+        unsigned int count;                             // acquisitions not yet released (0 if the record is free)
+        int inherited;                                  // highest priority inherited through the synchronizer (guarded by lock_state())
+        Element by_owner;
+        Element by_synchronizer;
+    };
+    typedef List<Ownership> Ownerships;
+
+    static const unsigned int OWNERSHIPS = (Traits<Synchronizer>::priority_inversion_protocol == Priority_Inversion_Protocol::NONE) ? 0 : Traits<Synchronizer>::ownerships;
 
     // Thread Configuration
     struct Configuration {
@@ -89,8 +134,9 @@ public:
 
     const volatile Criterion & priority() const { return _link.rank(); }
     void priority(const Criterion & p);
-    void apply_new_priority(int new_priority);
-    void restore_priority();
+
+    unsigned long affinity() { return criterion().affinity(); }
+    void affinity(unsigned long mask);
 
     int join();
     void pass();
@@ -111,45 +157,83 @@ protected:
 
     static Thread * volatile running() { return _scheduler.chosen(); }
 
-    static void lock(Spin * lock = &_lock) {
+    // Kernel Locking
+    // There is no global kernel lock. Each scheduling queue is guarded by its own lock (_lock[q], with
+    // q = Criterion::queue()), each synchronizer by the lock of its waiting Queue, the alarm queues by
+    // Alarm::_lock[], the system heap by _heap_lock and its per-CPU caches by _heap_cache_lock[]. A
+    // thread's state (i.e. _state, _waiting, _joining and its rank) is guarded by the lock of its
+    // scheduling queue and, while it is WAITING, also by the lock of the Queue it waits on (see
+    // lock_state()). Locks are always acquired in this order:
+    //   1. a synchronizer's Queue lock (another synchronizer's only to requeue a thread that owns the first, or
+    //      a Condition's before its Mutex's, to move waiters from one to the other)
+    //   2. scheduling queue locks (two of them in address order)
+    //   3. Alarm::_lock[] and _heap_cache_lock[], which precedes _heap_lock (leaves)
+    // Interrupts are disabled while any lock is held on a CPU and a thread never dispatches holding
+    // anything but the lock of the current scheduling queue, so rescheduling requested by a thread
+    // holding other locks is deferred until it releases the last one (see unlock()).
+    static void lock(Spin * lock = &_lock[Criterion::current_queue()]) {
         CPU::int_disable();
-        if(multicore) {
-            lock->acquire();
-            if (lock == &_lock)
-                db<Thread>(TRC) << "lock value=" << lock->level() << endl;
+        acquire(lock);
+    }
+
+    static void unlock(Spin * lock = &_lock[Criterion::current_queue()]) {
+        release(lock);
+        if(!locked() && _not_booting) {
+            if(_deferred_reschedule[CPU::id()]) {
+                _deferred_reschedule[CPU::id()] = false;
+                acquire(&_lock[Criterion::current_queue()]);
+                reschedule();
+                release(&_lock[Criterion::current_queue()]);
+            }
+            CPU::int_enable();
         }
+    }
+
+    static bool locked() { return (_locks[CPU::id()] > 0); }
 
+    static void acquire(Spin * lock) {
+        _locks[CPU::id()]++;
+        if(multicore)
+            lock->acquire();
     }
 
-    static void unlock(Spin * lock = &_lock) {
-        if(multicore) {
-            if (lock == &_lock)
-                db<Thread>(TRC) << "unlocked" << endl;
+    static void release(Spin * lock) {
+        if(multicore)
             lock->release();
-        }
-        if(_not_booting)
-            CPU::int_enable();
+        _locks[CPU::id()]--;
     }
 
-    static bool locked() {
-        if (multicore)
-            return _lock.taken(); 
-        else
-            return CPU::int_enabled();
-    }
+    Spin * queue_lock() { return &_lock[criterion().queue()]; }
+
+    Queue * lock_state();
+    void unlock_state(Queue * waiting);
 
     static void sleep(Queue * q);
     static void wakeup(Queue * q);
+    static void wakeup(Queue * q, unsigned int n);
     static void wakeup_all(Queue * q);
+    static Thread * requeue(Queue * from, Queue * to);
 
     static void reschedule();
     static void reschedule(unsigned int cpu_id);
     static void reschedule_all_cpus();
+    static void reschedule_cpus(unsigned long cpus);
+    static unsigned long preemptees(Thread * t, unsigned long cpus = 0);
     static void rescheduler(IC::Interrupt_Id interrupt);
     static void time_slicer(IC::Interrupt_Id interrupt);
 
     static void dispatch(Thread * prev, Thread * next, bool charge = true);
 
+    static Microsecond laxity_crossing(Thread * next);
+
+    // Priority inheritance (see Synchronizer_Common)
+    Queue * apply_new_priority(Ownership * o, int new_priority);
+    void restore_priority();
+    int inherited();
+
+    // Dynamic criteria (see Periodic_Thread)
+    void update_priority();
+
     static int idle();
 
 private:
@@ -163,13 +247,19 @@ protected:
     Thread * volatile _joining;
     Queue::Element _link;
     Microsecond _exec_start = 0U;
+    unsigned int _stack_size;
+    Ownership _ownerships[OWNERSHIPS];
+    Ownerships _owned;
 
     static bool _not_booting;
     static volatile unsigned int _thread_count;
     static unsigned long init_timestamp;
     static Scheduler_Timer * _timer;
     static Scheduler<Thread> _scheduler;
-    static Spin _lock;
+    static Spin _lock[Criterion::QUEUES];
+    static volatile unsigned int _locks[Traits<Machine>::CPUS];
+    static volatile bool _deferred_reschedule[Traits<Machine>::CPUS];
+    static Pool<> _stack_pool;          // released stacks of STACK_SIZE
 };
 
 
@@ -49,7 +49,7 @@ protected:
         ~Dynamic_Handler() {}
 
         void operator()() {
-            _thread->criterion().update();
+            _thread->update_priority();
 
             Semaphore_Handler::operator()();
         }
@@ -76,12 +76,12 @@ public:
     template<typename ... Tn>
     Periodic_Thread(const Microsecond & p, int (* entry)(Tn ...), Tn ... an)
     : Thread(Thread::Configuration(SUSPENDED, Criterion(p)), entry, an ...),
-      _semaphore(0), _handler(&_semaphore, this), _alarm(p, &_handler, INFINITE) { resume(); }
+      _semaphore(0), _handler(&_semaphore, this), _alarm(p, &_handler, INFINITE, release_cpu()) { resume(); }
 
     template<typename ... Tn>
     Periodic_Thread(const Configuration & conf, int (* entry)(Tn ...), Tn ... an)
     : Thread(Thread::Configuration(SUSPENDED, (conf.criterion != NORMAL) ? conf.criterion : Criterion(conf.period), conf.stack_size), entry, an ...),
-      _semaphore(0), _handler(&_semaphore, this), _alarm(conf.period, &_handler, conf.times) {
+      _semaphore(0), _handler(&_semaphore, this), _alarm(conf.period, &_handler, conf.times, release_cpu()) {
         if((conf.state == READY) || (conf.state == RUNNING)) {
             _state = SUSPENDED;
             resume();
@@ -103,6 +103,10 @@ public:
         return t->_alarm.times();
     }
 
+protected:
+    // Jobs of partitioned threads are released by the CPU they are bound to, so it never needs to be interrupted by another
+    unsigned int release_cpu() { return (Criterion::QUEUES > 1) ? criterion().queue() : CPU::id(); }
+
 protected:
     Semaphore _semaphore;
     Handler _handler;
@@ -9,6 +9,7 @@
 #include <utility/scheduling.h>
 #include <utility/math.h>
 #include <utility/convert.h>
+#include <utility/spin.h>
 
 __BEGIN_SYS
 
@@ -56,6 +57,7 @@ public:
     static const bool collecting = false;
     static const bool charging = false;
     static const bool awarding = false;
+    static const bool laxity = false;
     static const bool migrating = false;
     static const bool track_idle = false;
     static const bool task_wide = false;
@@ -74,6 +76,12 @@ public:
         unsigned int finished_jobs;             // number of finished jobs given by the number of times alarm->p() was called for this thread
         unsigned int missed_deadlines;          // number of missed deadlines given by the number of finished jobs (finished_jobs) minus the number of dispatched jobs (alarm_times->times)
 
+        // Migrations - Used by migrating policies (e.g. GEDF)
+        struct {
+            unsigned int migrations;            // number of dispatches on a CPU other than that of the previous one
+            unsigned int last_cpu;              // CPU of the last dispatch (ANY before the first)
+        };
+
         // CPU Execution Time (capture ts)
         static TSC::Time_Stamp _cpu_time[Traits<Build>::CPUS];              // accumulated CPU time in the current hyperperiod for each CPU
         static TSC::Time_Stamp _last_dispatch_time[Traits<Build>::CPUS];    // time Stamp of last dispatch in each CPU
@@ -90,8 +98,17 @@ public:
     unsigned int queue() const { return 0; }
     void queue(unsigned int q) {}
 
+    static unsigned int current_queue() { return 0; }
+
+    unsigned long affinity() const { return ~0UL; }
+    void affinity(unsigned long mask) {}
+    bool eligible(unsigned int cpu) const { return true; }
+    void dispatched(unsigned int cpu) {}
+
     bool update() { return false; }
     bool update_on_reschedule(const Microsecond & exec_start) { return false;}
+    bool update_on_wait() { return false; }
+    void retire() {}
 
     bool collect(bool end = false) { return false; }
     bool charge(bool end = false) { return true; }
@@ -133,6 +150,15 @@ public:
 
     bool protocol_applied() const { return _protocol_applied; }
 
+    // The priority the object would have if no protocol had been applied
+    int base_priority() const { return _protocol_applied ? _frozen_priority : _priority; }
+
+    // Resource Ceilings (see Synchronizer_Common)
+    // A resource's ceiling is the lowest among the ceiling() of its users, and ceiling_priority() is the priority it
+    // grants to a thread holding the resource. For fixed priorities, both are just the highest user priority.
+    int ceiling() const { return base_priority(); }
+    static int ceiling_priority(int ceiling) { return ceiling; }
+
     static const unsigned int HEADS = Traits<Machine>::CPUS;
     static unsigned int current_head() { return CPU::id(); }
 
@@ -228,6 +254,13 @@ public:
     EDF(const Microsecond & d, const Microsecond & p = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY);
 
     void update();
+
+    // A periodic thread's preemption level (as in SRP) is given by its relative deadline, so a resource's ceiling is the
+    // shortest relative deadline among its users, which becomes an absolute deadline when the resource is acquired.
+    // Jobs with longer relative deadlines, released after that, can't preempt the holder, while those with shorter
+    // ones still can (i.e. Deadline Floor inheritance). Aperiodic threads don't contribute to ceilings.
+    int ceiling() const;
+    static int ceiling_priority(int ceiling);
 };
 
 class LLF: public Real_Time_Scheduler_Common
@@ -236,6 +269,7 @@ public:
     static const bool timed = true;
     static const bool dynamic = true;
     static const bool preemptive = true;
+    static const bool laxity = true;     // the running thread's priority decays as it executes (see update_on_reschedule())
 
 public:
     LLF(int p = APERIODIC): Real_Time_Scheduler_Common(p), _wcet(UNKNOWN) {}
@@ -244,11 +278,224 @@ public:
     void update();
     void update_on_reschedule(const Microsecond & exec_start);
 
+    // As for EDF, but with the shortest relative laxity (i.e. deadline minus WCET) among the users
+    int ceiling() const;
+    static int ceiling_priority(int ceiling) { return EDF::ceiling_priority(ceiling); }
+
 public:
     Microsecond _wcet;
 
 };
 
+
+// Partitioned Scheduling
+// Criteria that inherit from this class keep one scheduling queue per CPU (see Scheduling_Multilist),
+// so each CPU only ever touches its own queue to insert, remove, and choose threads. Threads are bound
+// to the CPU given at construction, or to one picked in round-robin if it is ANY. IDLE and MAIN are
+// always bound to the CPU that creates them.
+class Variable_Queue_Scheduler
+{
+public:
+    static const unsigned int QUEUES = Traits<Machine>::CPUS;
+
+protected:
+    Variable_Queue_Scheduler(unsigned int cpu)
+    : _queue((cpu == Scheduling_Criterion_Common::ANY) ? CPU::finc(_next_queue) % QUEUES : cpu % QUEUES) {}
+
+public:
+    const volatile unsigned int & queue() const volatile { return _queue; }
+    void queue(unsigned int q) { _queue = q; }
+
+    static unsigned int current_queue() { return CPU::id(); }
+
+protected:
+    volatile unsigned int _queue;
+
+    static volatile unsigned int _next_queue;
+};
+
+// Partitioned Rate Monotonic
+class PRM: public RM, public Variable_Queue_Scheduler
+{
+public:
+    using Variable_Queue_Scheduler::QUEUES;
+
+public:
+    PRM(int p = APERIODIC)
+    : RM(p), Variable_Queue_Scheduler(((p == IDLE) || (p == MAIN)) ? CPU::id() : ANY) {}
+    PRM(const Microsecond & d, const Microsecond & p = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY)
+    : RM(d, p, c, cpu), Variable_Queue_Scheduler(cpu) {}
+
+    using Variable_Queue_Scheduler::queue;
+    using Variable_Queue_Scheduler::current_queue;
+};
+
+// Partitioned Earliest Deadline First
+class PEDF: public EDF, public Variable_Queue_Scheduler
+{
+public:
+    using Variable_Queue_Scheduler::QUEUES;
+
+public:
+    PEDF(int p = APERIODIC)
+    : EDF(p), Variable_Queue_Scheduler(((p == IDLE) || (p == MAIN)) ? CPU::id() : ANY) {}
+    PEDF(const Microsecond & d, const Microsecond & p = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY)
+    : EDF(d, p, c, cpu), Variable_Queue_Scheduler(cpu) {}
+
+    using Variable_Queue_Scheduler::queue;
+    using Variable_Queue_Scheduler::current_queue;
+};
+
+// Partitioned Least Laxity First
+class PLLF: public LLF, public Variable_Queue_Scheduler
+{
+public:
+    using Variable_Queue_Scheduler::QUEUES;
+
+public:
+    PLLF(int p = APERIODIC)
+    : LLF(p), Variable_Queue_Scheduler(((p == IDLE) || (p == MAIN)) ? CPU::id() : ANY) {}
+    PLLF(const Microsecond & d, const Microsecond & wcet, const Microsecond & p = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY)
+    : LLF(d, wcet, p, c, cpu), Variable_Queue_Scheduler(cpu) {}
+
+    using Variable_Queue_Scheduler::queue;
+    using Variable_Queue_Scheduler::current_queue;
+};
+
+// Semi-partitioned Earliest Deadline First (C=D splitting)
+// Most threads are bound to a single CPU as in PEDF, but a thread that doesn't fit in any CPU may have each of its
+// jobs split between two of them: the job first runs on "first" for at most "budget" with a relative deadline equal
+// to that budget (C=D, so it is never postponed there), and is then handed over to "second", a higher numbered
+// CPU, to execute the rest of its capacity under its own deadline (see Thread::reschedule()). Unless a "cpu" is
+// given, threads are assigned as they are created (i.e. typically at startup, by main, in the order given by the
+// application, which should thus be that of decreasing utilization), by a first-fit pass over the CPUs using
+// their declared period, deadline, and capacity (see partition()). Threads without a capacity go round-robin.
+// Each thread gives its share of the CPUs back when destroyed (see retire()).
+class SPEDF: public EDF, public Variable_Queue_Scheduler
+{
+public:
+    using Variable_Queue_Scheduler::QUEUES;
+
+public:
+    SPEDF(int p = APERIODIC)
+    : EDF(p), Variable_Queue_Scheduler(((p == IDLE) || (p == MAIN)) ? CPU::id() : ANY), _first(_queue), _second(_queue), _budget(0), _executed(0), _share(0), _split_share(0) {}
+    SPEDF(const Microsecond & d, const Microsecond & p = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY);
+
+    void update();
+    void update_on_reschedule(const Microsecond & exec_start);
+    void update_on_wait();
+    void retire();
+
+    using Variable_Queue_Scheduler::queue;
+    using Variable_Queue_Scheduler::current_queue;
+
+    bool split() const { return _budget; }
+    unsigned int first() const { return _first; }
+    unsigned int second() const { return _second; }
+
+private:
+    static const unsigned long UNIT = 1000000;
+
+    void partition(const Microsecond & c, const Microsecond & p);
+    void shift(int ticks);
+
+private:
+    unsigned int _first;        // CPU each job is released on
+    unsigned int _second;       // CPU each job is handed over to after its first portion (if split)
+    unsigned long _budget;      // execution time (in ticks) of the first portion, which is also its relative deadline (0 if not split)
+    unsigned long _executed;    // execution time (in ticks) of the current job's first portion so far
+    unsigned long _share;       // utilization (parts per UNIT) the thread takes from "first" (see retire())
+    unsigned long _split_share; // utilization the thread takes from "second", if split
+
+    static unsigned long _utilization[Traits<Machine>::CPUS]; // parts per UNIT assigned to each CPU (see partition())
+    static Simple_Spin _lock;                                 // guards _utilization
+};
+
+// Global Scheduling
+// Criteria that inherit from this class share a single scheduling queue among all CPUs (one head each, see
+// Multihead_Scheduling_List), so the m highest priority ready threads are the ones running on the m CPUs and
+// threads migrate freely: a thread made ready is pushed to the CPU running the lowest priority thread it may
+// run on (see Thread::preemptees()), a thread displaced from a CPU is pushed on the same way, and a CPU that
+// reschedules pulls the highest priority thread it may run from the shared queue. Each migration thus costs
+// at most one IPI and one scan of the CPUs. Threads may be restricted to a set of CPUs (an affinity mask, all
+// of them by default or just "cpu" if one is given at construction) and count their migrations.
+class Migrating_Scheduler
+{
+public:
+    static const bool migrating = true;
+
+protected:
+    Migrating_Scheduler(unsigned int cpu, Scheduling_Criterion_Common::Statistics & s)
+    : _affinity((cpu == Scheduling_Criterion_Common::ANY) ? ~0UL : (1UL << (cpu % Traits<Machine>::CPUS))) {
+        s.migrations = 0;
+        s.last_cpu = Scheduling_Criterion_Common::ANY;
+    }
+
+public:
+    unsigned long affinity() const { return _affinity; }
+    void affinity(unsigned long mask) { _affinity = mask; }
+    bool eligible(unsigned int cpu) const { return _affinity & (1UL << cpu); }
+
+protected:
+    static void dispatched(Scheduling_Criterion_Common::Statistics & s, unsigned int cpu) {
+        if((s.last_cpu != cpu) && (s.last_cpu != Scheduling_Criterion_Common::ANY))
+            s.migrations++;
+        s.last_cpu = cpu;
+    }
+
+protected:
+    volatile unsigned long _affinity;
+};
+
+// Global Earliest Deadline First
+class GEDF: public EDF, public Migrating_Scheduler
+{
+public:
+    using Migrating_Scheduler::migrating;
+
+public:
+    GEDF(int p = APERIODIC): EDF(p), Migrating_Scheduler(ANY, _statistics) {}
+    GEDF(const Microsecond & d, const Microsecond & p = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY)
+    : EDF(d, p, c, cpu), Migrating_Scheduler(cpu, _statistics) {}
+
+    using Migrating_Scheduler::affinity;
+    using Migrating_Scheduler::eligible;
+    void dispatched(unsigned int cpu) { Migrating_Scheduler::dispatched(_statistics, cpu); }
+};
+
+// Global Least Laxity First
+class GLLF: public LLF, public Migrating_Scheduler
+{
+public:
+    using Migrating_Scheduler::migrating;
+
+public:
+    GLLF(int p = APERIODIC): LLF(p), Migrating_Scheduler(ANY, _statistics) {}
+    GLLF(const Microsecond & d, const Microsecond & wcet, const Microsecond & p = SAME, const Microsecond & c = UNKNOWN, unsigned int cpu = ANY)
+    : LLF(d, wcet, p, c, cpu), Migrating_Scheduler(cpu, _statistics) {}
+
+    using Migrating_Scheduler::affinity;
+    using Migrating_Scheduler::eligible;
+    void dispatched(unsigned int cpu) { Migrating_Scheduler::dispatched(_statistics, cpu); }
+};
+
 __END_SYS
 
+__BEGIN_UTIL
+
+// Partitioned criteria use one Scheduling_List per CPU instead of a single list shared by all heads
+template<typename T>
+class Scheduling_Queue<T, PRM>: public Scheduling_Multilist<T, PRM, typename Scheduling_Queue_Base<T, PRM>::Element, Scheduling_List<T, PRM, typename Scheduling_Queue_Base<T, PRM>::Element, typename Scheduling_Queue_Base<T, PRM>::List>> {};
+
+template<typename T>
+class Scheduling_Queue<T, PEDF>: public Scheduling_Multilist<T, PEDF, typename Scheduling_Queue_Base<T, PEDF>::Element, Scheduling_List<T, PEDF, typename Scheduling_Queue_Base<T, PEDF>::Element, typename Scheduling_Queue_Base<T, PEDF>::List>> {};
+
+template<typename T>
+class Scheduling_Queue<T, SPEDF>: public Scheduling_Multilist<T, SPEDF, typename Scheduling_Queue_Base<T, SPEDF>::Element, Scheduling_List<T, SPEDF, typename Scheduling_Queue_Base<T, SPEDF>::Element, typename Scheduling_Queue_Base<T, SPEDF>::List>> {};
+
+template<typename T>
+class Scheduling_Queue<T, PLLF>: public Scheduling_Multilist<T, PLLF, typename Scheduling_Queue_Base<T, PLLF>::Element, Scheduling_List<T, PLLF, typename Scheduling_Queue_Base<T, PLLF>::Element, typename Scheduling_Queue_Base<T, PLLF>::List>> {};
+
+__END_UTIL
+
 #endif
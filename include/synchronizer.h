@@ -5,87 +5,138 @@
 
 #include <architecture.h>
 #include <utility/handler.h>
+#include <utility/ring.h>
 #include <process.h>
 
 __BEGIN_SYS
 
 class Synchronizer_Common
 {
+    friend class Thread;                // for disown(), propagate(), and get_new_priority()
+
 protected:
     typedef Thread::Queue Queue;
     typedef Thread::Criterion Criterion;
+    typedef Thread::Ownership Ownership;
+    typedef Thread::Ownerships Ownerships;
 
+    static const int priority_inversion_protocol = Traits<Synchronizer>::priority_inversion_protocol;
+    static const unsigned int ADAPTIVE_SPIN = (Traits<Build>::CPUS > 1) ? Traits<Synchronizer>::adaptive_spin : 0;
 
 protected:
-    Synchronizer_Common(long size): _size(size) {
-        _thread_array = new Thread*[size];
-        for (int i = 0; i < size; i++) {
-            _thread_array[i] = nullptr;
-        }
-    }
-    
+    Synchronizer_Common(int ceiling = Criterion::CEILING, bool declared = false): _queue(this), _ceiling(ceiling), _declared(declared) {}
+
     ~Synchronizer_Common() { 
         begin_atomic(); 
         wakeup_all(); 
+        // Owners find out the synchronizer is gone next time they look at their records
+        while(!_owners.empty())
+            _owners.remove()->object()->synchronizer = 0;
         end_atomic();
-        delete[] _thread_array;
     }
 
     // Atomic operations
     bool tsl(volatile bool & lock) { return CPU::tsl(lock); }
     long finc(volatile long & number) { return CPU::finc(number); }
     long fdec(volatile long & number) { return CPU::fdec(number); }
+    long cas(volatile long & value, long compare, long replacement) { return CPU::cas(value, compare, replacement); }
+    long fas(volatile long & value, long replacement) {
+        long old;
+        do old = value; while(CPU::cas(value, old, replacement) != old);
+        return old;
+    }
 
-    // Thread operations
-    void begin_atomic() { Thread::lock(); }
-    void end_atomic() { Thread::unlock(); }
-
-    void sleep() { Thread::sleep(&_queue); }
-    void wakeup() { Thread::wakeup(&_queue); }
-    void wakeup_all() { Thread::wakeup_all(&_queue); }
+    // Ceiling (for CEILING and SRP)
+    // Unless declared at construction, the ceiling is derived from the threads registered as users of the synchronizer,
+    // or is the global Criterion::CEILING if there are none
+    void register_user(Thread * t) {
+        begin_atomic();
+        int c = t->criterion().ceiling();
+        if (!_declared) {
+            _ceiling = c;
+            _declared = true;
+        } else if (c < _ceiling)
+            _ceiling = c;
+        end_atomic();
+    }
 
+    // Thread operations
+    // Each synchronizer is guarded by the lock of its own waiting queue (see Thread::lock())
+    void begin_atomic() { Thread::lock(_queue.lock()); }
+    void end_atomic() { Thread::unlock(_queue.lock()); }
+
+    Thread * running() { return Thread::running(); }
+    void sleep(Queue * q) { Thread::sleep(q); }
+    void wakeup(Queue * q) { Thread::wakeup(q); }
+    void wakeup(Queue * q, unsigned int n) { Thread::wakeup(q, n); }
+    void wakeup_all(Queue * q) { Thread::wakeup_all(q); }
+    void sleep() { sleep(&_queue); }
+    void wakeup() { wakeup(&_queue); }
+    void wakeup_all() { wakeup_all(&_queue); }
+    Thread * requeue(Queue * from) { return Thread::requeue(from, &_queue); }
+
+    // Priority inversion protocol
+    // Priorities are inherited transitively: a thread blocking on a synchronizer boosts its owners, those of them
+    // waiting on other synchronizers boost the owners of these, and so on. Each boost is also kept in the ownership
+    // record it came through, so a thread releasing a synchronizer falls back to the highest priority it still
+    // inherits through the others it owns, instead of straight to its own. With SRP, owners are boosted to the
+    // synchronizer's ceiling as soon as they acquire it, so, on a single CPU, a thread never blocks on a synchronizer
+    // whose users all registered: it can only be kept from starting while another user is inside.
+
+    // The running thread becomes an owner of the synchronizer, inheriting from the threads still waiting on it
     void insert() {
         if (priority_inversion_protocol == Priority_Inversion_Protocol::NONE)
             return;
 
-        Thread* current_thread = Thread::running();
-        for (int i = 0; i <_size; i++) {
-            if (_thread_array[i] == nullptr) {
-                _thread_array[i] = current_thread;
-                break;
+        Thread * current_thread = Thread::running();
+        Ownership * o = ownership(current_thread);
+        if (!o) {
+            o = spare(current_thread);
+            if (!o) {
+                db<Synchronizer>(WRN) << "Synchronizer::insert(this=" << this << "): thread " << current_thread << " already owns " << Thread::OWNERSHIPS
+                                      << " synchronizers, so no priority will be inherited through this one (see Traits<Synchronizer>::ownerships)!" << endl;
+                return;
             }
+            o->owner = current_thread;
+            o->synchronizer = this;
+            o->inherited = Criterion::IDLE;
+            current_thread->_owned.insert(&o->by_owner);
+            _owners.insert(&o->by_synchronizer);
         }
+        o->count++;
 
+        if (priority_inversion_protocol == Priority_Inversion_Protocol::SRP)
+            current_thread->apply_new_priority(o, Criterion::ceiling_priority(_ceiling));
+        else if (!_queue.empty())
+            current_thread->apply_new_priority(o, get_new_priority(_queue.head()->object()));
     }
 
-    void apply_new_priority() {
+    // The running thread (or "thread") is about to block on the synchronizer, so its owners (and theirs, along the
+    // chain) get boosted
+    void apply_new_priority(Thread * thread = Thread::running()) {
         if (priority_inversion_protocol == Priority_Inversion_Protocol::NONE)
             return;
 
-        Thread* current_thread = Thread::running();
-        for (int i = 0; i < _size; i++) {
-            if (current_thread->priority() < _thread_array[i]->priority()) {
-                _thread_array[i]->apply_new_priority(get_new_priority(current_thread));
-                db<Synchronizer>(INF) << "\nPriority inversion protocol applied!";
-                return;
-            }
-        }
+        propagate(this, get_new_priority(thread));
     }
 
+    // The running thread releases the synchronizer, giving up the priority it inherited through it
     void restore_priority() {
         if (priority_inversion_protocol == Priority_Inversion_Protocol::NONE)
             return;
 
-        Thread* current_thread = Thread::running();
-        for (int i = 0; i < _size; i++) {
-            if (_thread_array[i] == current_thread) {
-                if (current_thread->criterion().protocol_applied()) {
-                    _thread_array[i]->restore_priority();
-                }
-                _thread_array[i] = nullptr;
-                db<Synchronizer>(INF) << "\nPriority inversion protocol restored!";
-                return;
-            }
+        Thread * current_thread = Thread::running();
+        Ownership * o = ownership(current_thread);
+        if (!o || --o->count)
+            return;
+
+        current_thread->_owned.remove(&o->by_owner);
+        _owners.remove(&o->by_synchronizer);
+        o->synchronizer = 0;
+
+        if (current_thread->criterion().protocol_applied()) {
+            current_thread->restore_priority();
+            db<Synchronizer>(INF) << "\nPriority inversion protocol restored!";
         }
     }
 
@@ -96,31 +147,127 @@ private:
         case Priority_Inversion_Protocol::NONE:  // Never runs.
             return 0;
         case Priority_Inversion_Protocol::CEILING:
-            return Criterion::CEILING;
+        case Priority_Inversion_Protocol::SRP:
+            return Criterion::ceiling_priority(_ceiling);
         case Priority_Inversion_Protocol::INHERITANCE:
             return current_thread->priority(); 
         }
+        return 0;
+    }
+
+    // Boosts the owners of "s" to "priority" and, for those that were raised while waiting on another synchronizer,
+    // the owners of that one too, and so on along the chain. Must be called with the lock of "s" held. The lock of
+    // each synchronizer down the chain is held while its owners are boosted (locks are recursive, so cycles, which
+    // are deadlocks anyway, just stop at the depth limit).
+    static void propagate(Synchronizer_Common * s, int priority, unsigned int depth = 0) {
+        for (Ownerships::Iterator i = s->_owners.begin(); i != s->_owners.end(); i++) {
+            Ownership * o = i->object();
+            Queue * waiting = o->owner->apply_new_priority(o, priority);
+            db<Synchronizer>(INF) << "\nPriority inversion protocol applied!";
+
+            Synchronizer_Common * next = waiting ? waiting->synchronizer() : 0;
+            if (next && (depth < Traits<Application>::MAX_THREADS)) {
+                Thread::lock(waiting->lock());
+                propagate(next, priority, depth + 1);
+                Thread::unlock(waiting->lock());
+            }
+        }
+    }
+
+    // The record of "thread" owning this synchronizer, if any. Only "thread" itself changes its list of records,
+    // so it doesn't need locking, but records of destroyed synchronizers are dropped as they are found.
+    Ownership * ownership(Thread * thread) {
+        for (Ownerships::Iterator i = thread->_owned.begin(); i != thread->_owned.end();) {
+            Ownership * o = i->object();
+            i++;
+            if (o->synchronizer == this)
+                return o;
+            if (!o->synchronizer) {
+                thread->_owned.remove(&o->by_owner);
+                o->count = 0;
+            }
+        }
+        return 0;
+    }
+
+    static Ownership * spare(Thread * thread) {
+        for (unsigned int i = 0; i < Thread::OWNERSHIPS; i++)
+            if (!thread->_ownerships[i].count)
+                return &thread->_ownerships[i];
+        return 0;
+    }
+
+    // Called by ~Thread() for each synchronizer it still owns
+    static void disown(Synchronizer_Common * s, Ownership * o) {
+        s->begin_atomic();
+        if (o->synchronizer == s)
+            s->_owners.remove(&o->by_synchronizer);
+        s->end_atomic();
     }
 
 protected:
     Queue _queue;
-    Thread** _thread_array;
-    long _size;
-    static const int priority_inversion_protocol = Traits<Synchronizer>::priority_inversion_protocol;
+    Ownerships _owners;
+    volatile int _ceiling;
+    bool _declared;
 };
 
 
+// Mutex
+// Without a priority inversion protocol, the mutex works like a futex: lock() and unlock() on a free mutex are a single
+// CAS on its state, and only a contended one takes the lock of the waiting queue to sleep or to wake a waiter up. With a
+// protocol, every lock() and unlock() must update the owner's records (and possibly its priority), so they always do so
+// with the waiting queue locked. In either case, if Traits<Synchronizer>::adaptive_spin is set, a thread finding the
+// mutex locked by a thread that is running (i.e. on another CPU) first polls it for a while before going to sleep, since
+// a short critical section is likely to end sooner than a context switch and the IPI to wake the waiter up would take.
 class Mutex: protected Synchronizer_Common
 {
+    friend class Condition;             // for morph() and reacquire()
+
+private:
+    static const bool fast_path = (priority_inversion_protocol == Priority_Inversion_Protocol::NONE);
+
+    enum : long {
+        FREE = 0,
+        LOCKED = 1,
+        CONTENDED = 2   // locked and, possibly, with waiters
+    };
+
 public:
     Mutex();
+    Mutex(const Criterion & ceiling); // e.g. Mutex(Thread::HIGH), or Mutex(EDF(deadline)) for the shortest relative deadline
     ~Mutex();
 
     void lock();
     void unlock();
 
+    // Registered users raise the ceiling to their own priority (or preemption level)
+    using Synchronizer_Common::register_user;
+
 private:
-    volatile bool _locked;
+    // Returns true if the mutex was seen free within ADAPTIVE_SPIN polls, while its owner kept running
+    bool spin() {
+        for(unsigned int i = 0; i < ADAPTIVE_SPIN; i++) {
+            if(_state == FREE)
+                return true;
+            Thread * owner = _owner;
+            if(!owner || (owner->state() != Thread::RUNNING))
+                return false;
+        }
+        return false;
+    }
+
+    // Wait morphing (see Condition)
+    // The first (or every) thread waiting in "from", whose lock the caller holds, is moved to the mutex's queue to be
+    // handed the mutex by unlock(), unless the mutex is free, in which case the first one is awakened to take it
+    void morph(Queue * from, bool all);
+
+    // Locks the mutex again for a thread returning from Condition::wait(), whether it was handed over or not
+    void reacquire();
+
+private:
+    volatile long _state;
+    Thread * volatile _owner;
 };
 
 
@@ -132,14 +279,26 @@ public:
 
     void p();
     void v();
+    void v(unsigned int n); // as n v()s, but awakening all the threads to be released at once
+
+private:
+    // There is no single owner to watch, so a thread about to block on the semaphore just polls it for a while
+    void spin() {
+        for(unsigned int i = 0; (i < ADAPTIVE_SPIN) && (_value < 1); i++);
+    }
 
 private:
     volatile long _value;
 };
 
 
-// This is actually no Condition Variable
-// check http://www.cs.duke.edu/courses/spring01/cps110/slides/sem/sld002.htm
+// Condition Variable
+// wait(Mutex &) atomically releases the mutex and blocks the thread, which owns the mutex again when it returns. As
+// long as the mutex is held, signal() and broadcast() don't awaken waiters just to have them block on the mutex right
+// away: they move them to the mutex's queue (i.e. wait morphing), so each is awakened once, as the mutex is handed to
+// it. All threads waiting on a condition at a time must do so with the same mutex. The plain wait() remains, without
+// a mutex, as an event counter-less rendezvous (which is actually no Condition Variable,
+// check http://www.cs.duke.edu/courses/spring01/cps110/slides/sem/sld002.htm), and must not be mixed with wait(Mutex &).
 class Condition: protected Synchronizer_Common
 {
 public:
@@ -147,8 +306,212 @@ public:
     ~Condition();
 
     void wait();
+    void wait(Mutex & mutex);
     void signal();
     void broadcast();
+
+private:
+    Mutex * volatile _mutex;
+};
+
+
+// Reader-Writer Lock
+// Any number of readers may hold the lock at once, on any CPUs, but a writer holds it alone. Writers are preferred: once
+// one is waiting, arriving readers wait too, so a steady stream of readers can't starve writers. Readers and writers
+// wait in separate queues (both ordered by priority and guarded by the lock of the writers' one) and, as a writer
+// leaves, the lock goes to the highest priority waiter: either the next writer or all the waiting readers at once. The
+// lock is handed over to the threads it wakes up, which do not contend for it again. Readers and writers alike are
+// owners of the lock for the priority inversion protocol, so a blocked writer boosts every reader inside.
+class RW_Lock: protected Synchronizer_Common
+{
+public:
+    RW_Lock();
+    ~RW_Lock();
+
+    void lock_read();
+    void unlock_read();
+
+    void lock_write();
+    void unlock_write();
+
+private:
+    Queue _readers_queue;
+    volatile long _readers;
+    volatile bool _writing;
+};
+
+
+// Sequence Lock
+// Readers take a snapshot of the sequence number, read the data and then check whether the sequence changed meanwhile,
+// in which case they must read it all again:
+//     unsigned long s;
+//     do {
+//         s = seqlock.read_begin();
+//         copy = data;
+//     } while(seqlock.read_retry(s));
+// Writers are serialized by a Mutex and make the sequence odd while they write. A reader that finds the sequence even
+// writes no shared memory and never delays a writer. A reader that finds it odd, though, waits for the writer on that
+// Mutex instead of spinning, since the writer might have been preempted on the reader's own CPU. That takes and
+// releases the Mutex, so such a reader does write to it and may hold off the next writer for as long as that lasts.
+// Data read inside the loop may be inconsistent and must not be acted upon before read_retry() returns false.
+class Seqlock
+{
+public:
+    Seqlock();
+    ~Seqlock();
+
+    unsigned long read_begin() {
+        unsigned long s = _sequence;
+        while(s & 1) {
+            _writer.lock();
+            _writer.unlock();
+            s = _sequence;
+        }
+        CPU::fence();
+        return s;
+    }
+
+    bool read_retry(unsigned long s) {
+        CPU::fence();
+        return (_sequence != s);
+    }
+
+    void write_lock();
+    void write_unlock();
+
+private:
+    volatile unsigned long _sequence;
+    Mutex _writer;
+};
+
+
+// Barrier
+// Holds each of its participants in wait() until all of them have arrived, and then releases them all at once, over
+// and over (i.e. a cyclic barrier). Arrivals are counted in a two-level combining tree, with one counter per CPU in its
+// own cache line and another for the CPUs, so threads on different CPUs don't all contend for a single counter: each
+// thread counts itself in the counter of its CPU (or of the next one with room left, as threads may be unevenly spread
+// among CPUs) and the last one to arrive there counts the CPU at the root. The last thread to arrive at the root resets
+// the counters and releases everybody by reversing the barrier's sense. Waiters may poll the sense for a while (e.g.
+// when all participants run on their own CPUs) before going to sleep. wait() returns true for the thread that released
+// the others (e.g. to do serial work between phases), and arrive() counts an arrival (e.g. of a Barrier_Handler) without
+// waiting.
+class Barrier: protected Synchronizer_Common
+{
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+
+    struct Counter {
+        volatile long count;
+        long expected;
+        char padding[Traits<CPU>::CACHE_LINE_SIZE - 2 * sizeof(long)];
+    };
+
+public:
+    Barrier(unsigned int participants, unsigned int spin = ADAPTIVE_SPIN);
+    ~Barrier();
+
+    bool wait();
+    bool arrive();
+
+    unsigned int participants() const { return _participants; }
+
+private:
+    void release();
+
+private:
+    Counter _leaves[CPUS];
+    Counter _root;
+    unsigned int _participants;
+    unsigned int _spin;
+    volatile bool _sense;
+};
+
+
+// Mailbox
+// A bounded queue of N messages of type T between threads, possibly on different CPUs, built on a lock-free ring
+// (MPMC_Ring or, if there is a single sender and a single receiver, SPSC_Ring). Messages are passed without taking any
+// lock: send() blocks only if the mailbox is full and receive() only if it is empty. Threads about to block announce
+// themselves in a counter before a last try, so the other side only takes the synchronizer's lock to wake them up
+// when the counter says there is somebody to wake (which it checks after its own operation on the ring).
+template<typename T, unsigned int N, bool single = false>
+class Mailbox: protected Synchronizer_Common
+{
+private:
+    typedef typename IF<single, SPSC_Ring<T, N>, MPMC_Ring<T, N>>::Result Ring;
+
+public:
+    Mailbox(): _senders(this, _queue.lock()), _waiting_senders(0), _waiting_receivers(0) {
+        db<Synchronizer>(TRC) << "Mailbox() => " << this << endl;
+    }
+
+    ~Mailbox() {
+        db<Synchronizer>(TRC) << "~Mailbox(this=" << this << ")" << endl;
+
+        begin_atomic();
+        wakeup_all(&_senders);
+        end_atomic();
+    }
+
+    void send(const T & message) {
+        if(!_ring.insert(message)) {
+            begin_atomic();
+            _waiting_senders++;
+            CPU::fence();
+            while(!_ring.insert(message))
+                sleep(&_senders);
+            _waiting_senders--;
+            end_atomic();
+        }
+        notify(&_queue, _waiting_receivers);
+    }
+
+    T receive() {
+        T message;
+        if(!_ring.remove(&message)) {
+            begin_atomic();
+            _waiting_receivers++;
+            CPU::fence();
+            while(!_ring.remove(&message))
+                sleep();
+            _waiting_receivers--;
+            end_atomic();
+        }
+        notify(&_senders, _waiting_senders);
+        return message;
+    }
+
+    bool try_send(const T & message) {
+        if(!_ring.insert(message))
+            return false;
+        notify(&_queue, _waiting_receivers);
+        return true;
+    }
+
+    bool try_receive(T * message) {
+        if(!_ring.remove(message))
+            return false;
+        notify(&_senders, _waiting_senders);
+        return true;
+    }
+
+    bool empty() const { return _ring.empty(); }
+    unsigned long size() const { return _ring.size(); }
+
+private:
+    void notify(Queue * q, volatile long & waiting) {
+        CPU::fence();
+        if(waiting) {
+            begin_atomic();
+            wakeup(q);
+            end_atomic();
+        }
+    }
+
+private:
+    Ring _ring;
+    Queue _senders;         // receivers wait in _queue
+    volatile long _waiting_senders;
+    volatile long _waiting_receivers;
 };
 
 
@@ -191,6 +554,45 @@ private:
     Condition * _handler;
 };
 
+// An event handler that arrives at a barrier (see handler.h)
+class Barrier_Handler: public Handler
+{
+public:
+    Barrier_Handler(Barrier * h) : _handler(h) {}
+    ~Barrier_Handler() {}
+
+    void operator()() { _handler->arrive(); }
+
+private:
+    Barrier * _handler;
+};
+
+// An event handler that releases the write side of a reader-writer lock (see handler.h)
+class RW_Lock_Handler: public Handler
+{
+public:
+    RW_Lock_Handler(RW_Lock * h) : _handler(h) {}
+    ~RW_Lock_Handler() {}
+
+    void operator()() { _handler->unlock_write(); }
+
+private:
+    RW_Lock * _handler;
+};
+
+// An event handler that ends a write on a sequence lock (see handler.h)
+class Seqlock_Handler: public Handler
+{
+public:
+    Seqlock_Handler(Seqlock * h) : _handler(h) {}
+    ~Seqlock_Handler() {}
+
+    void operator()() { _handler->write_unlock(); }
+
+private:
+    Seqlock * _handler;
+};
+
 __END_SYS
 
 #endif
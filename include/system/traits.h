@@ -116,8 +116,11 @@ class Fixed_CPU;
 class CPU_Affinity;
 class GEDF;
 class PEDF;
+class SPEDF;
 class CEDF;
 class PRM;
+class PLLF;
+class GLLF;
 class EA_PEDF;
 
 class Address_Space;
@@ -127,6 +130,9 @@ class Synchronizer;
 class Mutex;
 class Semaphore;
 class Condition;
+class RW_Lock;
+class Seqlock;
+class Barrier;
 
 class Time;
 class Clock;
@@ -171,6 +177,16 @@ template<typename Component> class Authenticated;
 template<typename Component> class Shared;
 template<typename Component> class Remote;
 
+enum Heap_Allocator {
+    FIRST_FIT,
+    SEGREGATED_FIT
+};
+
+enum Spin_Lock_Algorithm {
+    TEST_AND_SET,   // waiters race for the lock word
+    TICKET          // waiters get the lock in arrival (FIFO) order
+};
+
 // Configuration Tokens
 struct Traits_Tokens
 {
@@ -206,6 +222,15 @@ struct Traits_Tokens
 
     // Default aspects
     typedef ALIST<> ASPECTS;
+
+    // Defaults for options applications only declare (in the Traits<> noted) to change them
+    static const bool tickless = false;                   // Traits<Build>: sets Traits<Timer>::tickless, which machines take from Traits<Build>
+    static const bool high_resolution = false;            // Traits<Alarm>: absolute deadlines at the timer's CLOCK (requires Traits<Timer>::tickless)
+    static const bool per_cpu_queues = false;             // Traits<Alarm>: each CPU keeps and handles the alarms it creates
+    static const int heap_allocator = Heap_Allocator::FIRST_FIT; // Traits<System>: or SEGREGATED_FIT (TLSF) for bounded allocation time
+    static const int algorithm = Spin_Lock_Algorithm::TEST_AND_SET; // Traits<Spin>: or TICKET for FIFO hand-off under contention
+    static const unsigned int adaptive_spin = 0;          // Traits<Synchronizer>: polls a waiter makes while the owner runs on another CPU before blocking (0 = always block)
+    static const unsigned int ownerships = 8;             // Traits<Synchronizer>: synchronizers a thread can own at once and still have the priority inversion protocol applied
 };
 
 // Interrupt souces names (for all machines; overridden at Traits<IC>; 0 => not used)
@@ -521,8 +546,16 @@ enum PMU_Event {
 
 enum Priority_Inversion_Protocol {
     NONE, 
-    CEILING, 
-    INHERITANCE
+    CEILING,        // owners are raised to the synchronizer's ceiling when a thread blocks on it
+    INHERITANCE,
+    SRP             // owners are raised to the synchronizer's ceiling as they acquire it (Immediate Priority Ceiling
+                    // for fixed priorities and Stack Resource Policy preemption levels for EDF and LLF)
+};
+
+enum Scheduling_Queue_Backend {
+    ORDERED_LIST,
+    PAIRING_HEAP,
+    LEVEL_BITMAP
 };
 
 template<typename T>
@@ -182,6 +182,9 @@ enum
     ALARM_ID,
     CHRONOMETER_ID,
     UTILITY_ID,
+    RW_LOCK_ID,
+    SEQLOCK_ID,
+    BARRIER_ID,
     LAST_COMPONENT_ID,
 
     FIRST_MEDIATOR_ID = 100,
@@ -242,6 +245,9 @@ template<> struct Type<Segment> { static const Type_Id ID = SEGMENT_ID; };
 template<> struct Type<Mutex> { static const Type_Id ID = MUTEX_ID; };
 template<> struct Type<Semaphore> { static const Type_Id ID = SEMAPHORE_ID; };
 template<> struct Type<Condition> { static const Type_Id ID = CONDITION_ID; };
+template<> struct Type<RW_Lock> { static const Type_Id ID = RW_LOCK_ID; };
+template<> struct Type<Seqlock> { static const Type_Id ID = SEQLOCK_ID; };
+template<> struct Type<Barrier> { static const Type_Id ID = BARRIER_ID; };
 
 template<> struct Type<Clock> { static const Type_Id ID = CLOCK_ID; };
 template<> struct Type<Chronometer> { static const Type_Id ID = CHRONOMETER_ID; };
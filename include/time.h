@@ -6,7 +6,7 @@
 #include <machine/rtc.h>
 #include <machine/timer.h>
 #include <process.h>
-#include <utility/queue.h>
+#include <utility/wheel.h>
 #include <utility/handler.h>
 
 __BEGIN_SYS
@@ -33,17 +33,28 @@ class Alarm
     friend class System;                        // for init()
     friend class Alarm_Chronometer;             // for elapsed()
     friend class Periodic_Thread;               // for ticks(), times(), and elapsed()
-    friend class Thread;                        // for elapsed()
-    friend class FCFS;                          // for ticks() and elapsed()
-    friend class EDF;                           // for ticks() and elapsed()
-    friend class LLF;                           // for ticks() and elapsed()
+    friend class Thread;                        // for scheduling_elapsed() and scheduling_period()
+    friend class FCFS;                          // for scheduling_elapsed()
+    friend class EDF;                           // for scheduling_ticks() and scheduling_elapsed()
+    friend class LLF;                           // for scheduling_ticks() and scheduling_elapsed()
+    friend class SPEDF;                         // for scheduling_ticks() and scheduling_elapsed()
 
 private:
     typedef Timer_Common::Tick Tick;
-    typedef Relative_Queue<Alarm, Tick> Queue;
+
+    // In high resolution mode, alarms run at the timer's CLOCK (i.e. Ticks are mtime counts) and the next
+    // expiration is programmed straight into the timer
+    static const bool high_resolution = Traits<Alarm>::high_resolution && Timer::tickless;
+
+    // Alarms are ranked by their absolute expiration tick
+    typedef Timing_Wheel<Alarm, Tick> Queue;
+
+    // With per-CPU queues, each Alarm is kept and handled by the CPU that created it (or the one it was given),
+    // instead of all of them by CPU 0
+    static const unsigned int QUEUES = Traits<Alarm>::per_cpu_queues ? Traits<Machine>::CPUS : 1;
 
 public:
-    Alarm(const Microsecond & time, Handler * handler, unsigned int times = 1);
+    Alarm(const Microsecond & time, Handler * handler, unsigned int times = 1, unsigned int cpu = CPU::id());
     ~Alarm();
 
     const Microsecond & period() const { return _time; }
@@ -56,15 +67,29 @@ public:
     static void delay(const Microsecond & time);
 
 private:
+    // For delay(): the alarm wakes up the thread sleeping on "sleeping" instead of calling a handler
+    Alarm(const Microsecond & time, Thread::Queue * sleeping);
+
     unsigned int times() const { return _times; }
 
-    static volatile Tick & elapsed() { return _elapsed; }
+    // In tickless mode, time is read from the timer instead of being counted by handler()
+    static Tick elapsed() { return Timer::tickless ? _timer->elapsed() : _elapsed; }
 
     static Microsecond timer_period() { return 1000000 / frequency(); }
-    static Tick ticks(const Microsecond & time) { return (time + timer_period() / 2) / timer_period(); }
+    static Tick ticks(const Microsecond & time) {
+        return high_resolution ? Convert::us2count<Tick, Microsecond>(frequency(), time) : (time + timer_period() / 2) / timer_period();
+    }
+
+    // Scheduling criteria keep their (int) priorities at Traits<Timer>::FREQUENCY, which would soon overflow at high resolution
+    static Microsecond scheduling_period() { return 1000000 / Traits<Timer>::FREQUENCY; }
+    static Tick scheduling_ticks(const Microsecond & time) { return (time + scheduling_period() / 2) / scheduling_period(); }
+    static Tick scheduling_elapsed() { return high_resolution ? elapsed() / (frequency() / Traits<Timer>::FREQUENCY) : elapsed(); }
+
+    static void lock(unsigned int q) { Thread::lock(&_lock[q]); }
+    static void unlock(unsigned int q) { Thread::unlock(&_lock[q]); }
 
-    static void lock() { Thread::lock(&_lock); }
-    static void unlock() { Thread::unlock(&_lock); }
+    void enqueue();
+    static void program(unsigned int q);
 
     static void handler(IC::Interrupt_Id i);
 
@@ -73,14 +98,16 @@ private:
 private:
     Microsecond _time;
     Handler * _handler;
+    Thread::Queue * _sleeping;
     unsigned int _times;
     Tick _ticks;
+    unsigned int _queue;
     Queue::Element _link;
 
     static Alarm_Timer * _timer;
     static volatile Tick _elapsed;
-    static Queue _request;
-    static Spin _lock;
+    static Queue _request[QUEUES];
+    static Spin _lock[QUEUES];
 };
 
 
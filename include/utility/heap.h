@@ -15,6 +15,10 @@ class Simple_Heap: private Grouping_List<char>
 protected:
     static const bool typed = Traits<System>::multiheap;
 
+public:
+    // Room for the block's size and, for typed heaps, for a pointer to the heap, right before the address returned by alloc()
+    static const unsigned int HEADER = (typed ? sizeof(void *) : 0) + sizeof(long);
+
 public:
     using Grouping_List<char>::empty;
     using Grouping_List<char>::size;
@@ -36,29 +40,15 @@ public:
         if(!bytes)
             return 0;
 
-        if(!Traits<CPU>::unaligned_memory_access)
-            while((bytes % sizeof(void *)))
-                ++bytes;
+        bytes = block_size(bytes);
 
-        if(typed)
-            bytes += sizeof(void *);  // add room for heap pointer
-        bytes += sizeof(long);        // add room for size
-        if(bytes < sizeof(Element))
-            bytes = sizeof(Element);
-
-        Element * e = search_decrementing(bytes);
-        if(!e) {
+        void * addr = alloc_block(bytes);
+        if(!addr) {
             out_of_memory(bytes);
             return 0;
         }
 
-        long * addr = reinterpret_cast<long *>(e->object() + e->size());
-
-        if(typed)
-            *addr++ = reinterpret_cast<long>(this);
-        *addr++ = bytes;
-
-        db<Heaps>(TRC) << ") => " << reinterpret_cast<void *>(addr) << endl;
+        db<Heaps>(TRC) << ") => " << addr << endl;
 
         return addr;
     }
@@ -86,8 +76,316 @@ public:
         heap->free(addr, bytes);
     }
 
+    // Size of the block (i.e. including HEADER) allocated at "ptr"
+    static unsigned long size_of(void * ptr) { return reinterpret_cast<long *>(ptr)[-1]; }
+
+    // Size of the block (i.e. including HEADER) that holds an allocation of "bytes"
+    static unsigned long block_size(unsigned long bytes) {
+        if(!Traits<CPU>::unaligned_memory_access)
+            while((bytes % sizeof(void *)))
+                ++bytes;
+
+        bytes += HEADER;
+        if(bytes < sizeof(Element))
+            bytes = sizeof(Element);
+
+        return bytes;
+    }
+
+protected:
+    // Allocates a block of exactly "bytes" (as given by block_size()), returning 0 if there is no room for it
+    void * alloc_block(unsigned long bytes) {
+        Element * e = search_decrementing(bytes);
+        if(!e)
+            return 0;
+
+        long * addr = reinterpret_cast<long *>(e->object() + e->size());
+
+        if(typed)
+            *addr++ = reinterpret_cast<long>(this);
+        *addr++ = bytes;
+
+        return addr;
+    }
+
+    // Releases the block allocated at "ptr"
+    void free_block(void * ptr) { free(reinterpret_cast<char *>(ptr) - HEADER, size_of(ptr)); }
+
+    void out_of_memory(unsigned long bytes);
+};
+
+
+// Two-Level Segregated Fit Heap
+// Free blocks are kept in lists segregated by size: a first level of power-of-two
+// ranges, each split into 2^SL_BITS second-level classes, with a bitmap per level
+// telling which lists are not empty. alloc() rounds the request up to the next
+// class, so any block from the first non-empty list found with two bit scans fits,
+// and free() coalesces with the physical neighbours through boundary tags (the
+// size and flags in each block's header, plus a copy of the size at the end of
+// free blocks), so both run in constant time regardless of how fragmented the heap
+// gets. Memory handed to free(addr, bytes) becomes a region closed by a sentinel.
+class TLSF_Heap
+{
+protected:
+    static const bool typed = Traits<System>::multiheap;
+
+public:
+    // Room for the block's size and flags and, for typed heaps, for a pointer to the heap, right before the address returned by alloc()
+    static const unsigned int HEADER = (typed ? sizeof(void *) : 0) + sizeof(long);
+
 private:
+    static const unsigned int ALIGN = sizeof(void *);
+    static const unsigned int SL_BITS = 4;
+    static const unsigned int SLS = 1 << SL_BITS;
+    static const unsigned int FL_SHIFT = SL_BITS + 3;  // blocks up to 2^FL_SHIFT are all in the first list, spaced by ALIGN
+    static const unsigned int SMALL = 1 << FL_SHIFT;
+    static const unsigned int FLS = sizeof(unsigned int) * 8 - FL_SHIFT + 1; // blocks up to 4 GB
+
+    // Flags in the lower bits of the size tag, which are always zero due to alignment
+    enum : unsigned long {
+        FREE      = 1 << 0,
+        PREV_FREE = 1 << 1,
+        FLAGS     = FREE | PREV_FREE
+    };
+
+    // A free block's payload holds its links and ends with a copy of its size, used to reach it from the next block
+    struct Links {
+        char * next;
+        char * prev;
+    };
+
+    static const unsigned long MIN_BLOCK = HEADER + sizeof(Links) + sizeof(long);
+
+public:
+    TLSF_Heap(): _fl_map(0), _free(0), _blocks(0) {
+        db<Init, Heaps>(TRC) << "Heap() => " << this << endl;
+
+        for(unsigned int i = 0; i < FLS; i++) {
+            _sl_map[i] = 0;
+            for(unsigned int j = 0; j < SLS; j++)
+                _lists[i][j] = 0;
+        }
+    }
+
+    TLSF_Heap(void * addr, unsigned long bytes): TLSF_Heap() {
+        db<Init, Heaps>(TRC) << "Heap(addr=" << addr << ",bytes=" << bytes << ") => " << this << endl;
+
+        free(addr, bytes);
+    }
+
+    bool empty() const { return (_blocks == 0); }
+    unsigned long size() const { return _blocks; }
+    unsigned long grouped_size() const { return _free; }
+
+    void * alloc(unsigned long bytes) {
+        db<Heaps>(TRC) << "Heap::alloc(this=" << this << ",bytes=" << bytes;
+
+        if(!bytes)
+            return 0;
+
+        bytes = block_size(bytes);
+
+        void * addr = alloc_block(bytes);
+        if(!addr) {
+            out_of_memory(bytes);
+            return 0;
+        }
+
+        db<Heaps>(TRC) << ") => " << addr << endl;
+
+        return addr;
+    }
+
+    // Adds the memory at "addr" to the heap as a new region
+    void free(void * addr, unsigned long bytes) {
+        db<Heaps>(TRC) << "Heap::free(this=" << this << ",ptr=" << addr << ",bytes=" << bytes << ")" << endl;
+
+        char * b = reinterpret_cast<char *>(addr);
+        while(reinterpret_cast<unsigned long>(b) % ALIGN) {
+            b++;
+            if(!bytes--)
+                return;
+        }
+        bytes -= bytes % ALIGN;
+
+        if(!b || (bytes < MIN_BLOCK + HEADER))
+            return;
+
+        bytes -= HEADER; // the sentinel needs just a header
+        tag(b + bytes) = 0;
+        tag(b) = 0; // nothing before the region to coalesce with
+        release(b, bytes);
+    }
+
+    static void typed_free(void * ptr) {
+        reinterpret_cast<TLSF_Heap *>(reinterpret_cast<long *>(ptr)[-2])->free_block(ptr);
+    }
+
+    static void untyped_free(TLSF_Heap * heap, void * ptr) { heap->free_block(ptr); }
+
+    static unsigned long size_of(void * ptr) { return reinterpret_cast<unsigned long *>(ptr)[-1] & ~FLAGS; }
+
+    static unsigned long block_size(unsigned long bytes) {
+        while((bytes % ALIGN))
+            ++bytes;
+
+        bytes += HEADER;
+        if(bytes < MIN_BLOCK)
+            bytes = MIN_BLOCK;
+
+        return bytes;
+    }
+
+protected:
+    void * alloc_block(unsigned long bytes) {
+        unsigned int fl, sl;
+        if(!search(bytes, &fl, &sl))
+            return 0;
+
+        char * b = _lists[fl][sl];
+        unsigned long size = block(b);
+        remove(b, fl, sl);
+
+        if(size - bytes >= MIN_BLOCK) {
+            char * rest = b + bytes;
+            tag(rest) = 0;
+            make_free(rest, size - bytes);
+            insert(rest);
+            size = bytes;
+        } else
+            tag(b + size) &= ~PREV_FREE;
+
+        tag(b) = size; // used, and a free block's physical predecessor is never free
+        if(typed)
+            *reinterpret_cast<TLSF_Heap **>(b) = this;
+
+        return b + HEADER;
+    }
+
+    void free_block(void * ptr) {
+        db<Heaps>(TRC) << "Heap::free(this=" << this << ",ptr=" << ptr << ")" << endl;
+
+        char * b = reinterpret_cast<char *>(ptr) - HEADER;
+        release(b, block(b));
+    }
+
     void out_of_memory(unsigned long bytes);
+
+private:
+    static unsigned long & tag(char * b) { return *reinterpret_cast<unsigned long *>(b + HEADER - sizeof(long)); }
+    static unsigned long block(char * b) { return tag(b) & ~FLAGS; }
+    static Links * links(char * b) { return reinterpret_cast<Links *>(b + HEADER); }
+    static unsigned long & footer(char * b, unsigned long size) { return *reinterpret_cast<unsigned long *>(b + size - sizeof(long)); }
+
+    static unsigned int fls(unsigned long x) { return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(x); }
+
+    static void mapping(unsigned long size, unsigned int * fl, unsigned int * sl) {
+        if(size < SMALL) {
+            *fl = 0;
+            *sl = size / (SMALL / SLS);
+        } else {
+            unsigned int f = fls(size);
+            *sl = (size >> (f - SL_BITS)) ^ SLS;
+            *fl = f - FL_SHIFT + 1;
+        }
+    }
+
+    // Finds the first non-empty list whose blocks are all at least "size" bytes long
+    bool search(unsigned long size, unsigned int * fl, unsigned int * sl) {
+        if(size >= SMALL)
+            size += (1UL << (fls(size) - SL_BITS)) - 1;
+        mapping(size, fl, sl);
+        if(*fl >= FLS)
+            return false;
+
+        unsigned int map = _sl_map[*fl] & (~0U << *sl);
+        if(!map) {
+            unsigned int fmap = (*fl + 1 < FLS) ? _fl_map & (~0U << (*fl + 1)) : 0;
+            if(!fmap)
+                return false;
+            *fl = __builtin_ctz(fmap);
+            map = _sl_map[*fl];
+        }
+        *sl = __builtin_ctz(map);
+
+        return true;
+    }
+
+    // Frees the block at "b", merging it with its free physical neighbours
+    void release(char * b, unsigned long size) {
+        if(tag(b) & PREV_FREE) {
+            unsigned long prev_size = *reinterpret_cast<unsigned long *>(b - sizeof(long));
+            b -= prev_size;
+            remove(b);
+            size += prev_size;
+        }
+
+        char * next = b + size;
+        if(tag(next) & FREE) {
+            unsigned long next_size = block(next);
+            remove(next);
+            size += next_size;
+        }
+
+        tag(b) = 0;
+        make_free(b, size);
+        insert(b);
+    }
+
+    static void make_free(char * b, unsigned long size) {
+        tag(b) = size | FREE | (tag(b) & PREV_FREE);
+        footer(b, size) = size;
+        tag(b + size) |= PREV_FREE;
+    }
+
+    void insert(char * b) {
+        unsigned int fl, sl;
+        mapping(block(b), &fl, &sl);
+
+        Links * l = links(b);
+        l->prev = 0;
+        l->next = _lists[fl][sl];
+        if(l->next)
+            links(l->next)->prev = b;
+        _lists[fl][sl] = b;
+
+        _fl_map |= 1U << fl;
+        _sl_map[fl] |= 1U << sl;
+        _free += block(b);
+        _blocks++;
+    }
+
+    void remove(char * b) {
+        unsigned int fl, sl;
+        mapping(block(b), &fl, &sl);
+        remove(b, fl, sl);
+    }
+
+    void remove(char * b, unsigned int fl, unsigned int sl) {
+        Links * l = links(b);
+        if(l->next)
+            links(l->next)->prev = l->prev;
+        if(l->prev)
+            links(l->prev)->next = l->next;
+        else {
+            _lists[fl][sl] = l->next;
+            if(!l->next) {
+                _sl_map[fl] &= ~(1U << sl);
+                if(!_sl_map[fl])
+                    _fl_map &= ~(1U << fl);
+            }
+        }
+
+        _free -= block(b);
+        _blocks--;
+    }
+
+private:
+    unsigned int _fl_map;
+    unsigned int _sl_map[FLS];
+    char * _lists[FLS][SLS];
+    unsigned long _free;
+    unsigned long _blocks;
 };
 
 // Wrapper for non-atomic heap
@@ -101,17 +399,36 @@ public:
 
 
 // Wrapper for atomic heap
+// Blocks of up to 2^(MIN_CLASS + CLASSES - 1) bytes are rounded up to power-of-two size classes and, once freed,
+// kept in per-CPU caches, so most allocations and releases never touch the shared heap nor its lock. Caches are
+// refilled from and flushed to the shared heap in batches of BATCH blocks, holding up to LIMIT blocks per class.
 extern "C" {
     void _lock_heap();
     void _unlock_heap();
+    unsigned int _lock_heap_cache();            // returns the CPU whose cache was locked
+    void _unlock_heap_cache(unsigned int cpu);
 }
 
 template<typename T>
 class Heap_Wrapper<T, true>: public T
 {
+private:
+    static const unsigned int CPUS = Traits<Build>::CPUS;
+    static const unsigned int MIN_CLASS = 5;    // 32 bytes
+    static const unsigned int CLASSES = 7;      // up to 2 KB
+    static const unsigned int BATCH = 4;
+    static const unsigned int LIMIT = 16;
+
+    // Each CPU's cache is padded to a multiple of the cache line size, so CPUs don't write to each other's lines
+    struct Cache {
+        void * free[CLASSES];
+        unsigned int count[CLASSES];
+        char padding[Traits<CPU>::CACHE_LINE_SIZE - (CLASSES * (sizeof(void *) + sizeof(unsigned int))) % Traits<CPU>::CACHE_LINE_SIZE];
+    };
+
 public:
-    Heap_Wrapper() {}
-    Heap_Wrapper(void * addr, unsigned int bytes): T(addr, bytes) {}
+    Heap_Wrapper() { clear(); }
+    Heap_Wrapper(void * addr, unsigned int bytes): T(addr, bytes) { clear(); }
 
     bool empty() {
         enter();
@@ -128,16 +445,51 @@ public:
     }
 
     void * alloc(unsigned long bytes) {
-        enter();
-        void * tmp = T::alloc(bytes);
-        leave();
+        if(!bytes)
+            return 0;
+
+        unsigned int c = size_class(T::block_size(bytes));
+        if(c >= CLASSES) {
+            enter();
+            void * tmp = T::alloc(bytes);
+            leave();
+            return tmp;
+        }
+
+        unsigned int cpu = _lock_heap_cache();
+        Cache * cache = &_cache[cpu];
+        if(!cache->free[c])
+            refill(cache, c);
+        void * tmp = pop(cache, c);
+        _unlock_heap_cache(cpu);
+
+        if(!tmp) { // not even a single block of class c was left, so let the shared heap handle it
+            enter();
+            tmp = T::alloc(bytes);
+            leave();
+        }
+
         return tmp;
     }
 
     void free(void * ptr) {
-        enter();
-        T::free(ptr);
-        leave();
+        if(!ptr)
+            return;
+
+        unsigned long bytes = T::size_of(ptr);
+        unsigned int c = size_class(bytes);
+        if((c < CLASSES) && (bytes == class_size(c))) {
+            unsigned int cpu = _lock_heap_cache();
+            Cache * cache = &_cache[cpu];
+            push(cache, c, ptr);
+            if(cache->count[c] > LIMIT)
+                flush(cache, c);
+            _unlock_heap_cache(cpu);
+        } else {
+            enter();
+            T::free_block(ptr);
+            leave();
+        }
     }
 
     void free(void * ptr, unsigned long bytes) {
@@ -146,20 +498,75 @@ public:
         leave();
     }
 
+    static void typed_free(void * ptr) {
+        if(ptr)
+            static_cast<Heap_Wrapper *>(reinterpret_cast<T *>(reinterpret_cast<long *>(ptr)[-2]))->free(ptr);
+    }
+
+    static void untyped_free(Heap_Wrapper * heap, void * ptr) { heap->free(ptr); }
+
 private:
-    // void enter() { _lock_heap(); }
-    // void leave() { _unlock_heap(); }
+    static unsigned long class_size(unsigned int c) { return 1UL << (MIN_CLASS + c); }
+    static unsigned int size_class(unsigned long bytes) {
+        unsigned int bits = sizeof(unsigned long) * 8 - __builtin_clzl(bytes - 1);
+        return (bits > MIN_CLASS) ? bits - MIN_CLASS : 0;
+    }
+
+    static void * pop(Cache * cache, unsigned int c) {
+        void * ptr = cache->free[c];
+        if(ptr) {
+            cache->free[c] = *reinterpret_cast<void **>(ptr);
+            cache->count[c]--;
+        }
+        return ptr;
+    }
 
-    void enter() {  }
-    void leave() {  }
+    static void push(Cache * cache, unsigned int c, void * ptr) {
+        *reinterpret_cast<void **>(ptr) = cache->free[c];
+        cache->free[c] = ptr;
+        cache->count[c]++;
+    }
+
+    void refill(Cache * cache, unsigned int c) {
+        enter();
+        for(unsigned int i = 0; i < BATCH; i++) {
+            void * ptr = T::alloc_block(class_size(c));
+            if(!ptr)
+                break;
+            push(cache, c, ptr);
+        }
+        leave();
+    }
+
+    void flush(Cache * cache, unsigned int c) {
+        enter();
+        for(unsigned int i = 0; i < BATCH; i++)
+            T::free_block(pop(cache, c));
+        leave();
+    }
+
+    void clear() {
+        for(unsigned int i = 0; i < CPUS; i++)
+            for(unsigned int c = 0; c < CLASSES; c++) {
+                _cache[i].free[c] = 0;
+                _cache[i].count[c] = 0;
+            }
+    }
+
+    void enter() { _lock_heap(); }
+    void leave() { _unlock_heap(); }
+
+private:
+    Cache _cache[CPUS];
 };
 
 
 // Heap
-class Heap: public Heap_Wrapper<Simple_Heap, Traits<Machine>::multicore>
+// The allocator is either Simple_Heap's first fit or TLSF_Heap's segregated fit, as given by Traits<System>::heap_allocator
+class Heap: public Heap_Wrapper<IF<Traits<System>::heap_allocator == SEGREGATED_FIT, TLSF_Heap, Simple_Heap>::Result, Traits<Machine>::multicore>
 {
 private:
-    typedef Heap_Wrapper<Simple_Heap, Traits<Machine>::multicore> Base;
+    typedef Heap_Wrapper<IF<Traits<System>::heap_allocator == SEGREGATED_FIT, TLSF_Heap, Simple_Heap>::Result, Traits<Machine>::multicore> Base;
 
 public:
     Heap() {}
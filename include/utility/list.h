@@ -260,6 +260,83 @@ namespace List_Elements
         Element * _next;
     };
 
+    // Pairing Heap Scheduling Element
+    // _prev points to the left sibling, or to the parent for the leftmost child, _next to the right sibling
+    // and _child to the leftmost child. When the element is in an Ordered_List (e.g. a synchronizer's
+    // waiting queue), only _prev and _next are used, as in Doubly_Linked_Scheduling.
+    template<typename T, typename R = Rank>
+    class Pairing_Heap_Scheduling
+    {
+    public:
+        typedef T Object_Type;
+        typedef R Rank_Type;
+        typedef Pairing_Heap_Scheduling Element;
+
+    public:
+        Pairing_Heap_Scheduling(const T * o,  const R & r = 0): _object(o), _rank(r), _prev(0), _next(0), _child(0), _order(0) {}
+
+        T * object() const { return const_cast<T *>(_object); }
+
+        Element * prev() const { return _prev; }
+        Element * next() const { return _next; }
+        Element * child() const { return _child; }
+        void prev(Element * e) { _prev = e; }
+        void next(Element * e) { _next = e; }
+        void child(Element * e) { _child = e; }
+
+        unsigned long order() const { return _order; }
+        void order(unsigned long o) { _order = o; }
+
+        const R & rank() const { return _rank; }
+        void rank(const R & r) { _rank = r; }
+        int promote(const R & n = 1) { _rank -= n; return _rank; }
+        int demote(const R & n = 1) { _rank += n; return _rank; }
+
+    private:
+        const T * _object;
+        R _rank;
+        Element * _prev;
+        Element * _next;
+        Element * _child;
+        unsigned long _order;
+    };
+
+    // Bitmap Scheduling Element
+    // Remembers the level in which it was inserted, so it can be removed even if its rank changed meanwhile
+    template<typename T, typename R = Rank>
+    class Bitmap_Scheduling
+    {
+    public:
+        typedef T Object_Type;
+        typedef R Rank_Type;
+        typedef Bitmap_Scheduling Element;
+
+    public:
+        Bitmap_Scheduling(const T * o,  const R & r = 0): _object(o), _rank(r), _prev(0), _next(0), _level(0) {}
+
+        T * object() const { return const_cast<T *>(_object); }
+
+        Element * prev() const { return _prev; }
+        Element * next() const { return _next; }
+        void prev(Element * e) { _prev = e; }
+        void next(Element * e) { _next = e; }
+
+        unsigned int level() const { return _level; }
+        void level(unsigned int l) { _level = l; }
+
+        const R & rank() const { return _rank; }
+        void rank(const R & r) { _rank = r; }
+        int promote(const R & n = 1) { _rank -= n; return _rank; }
+        int demote(const R & n = 1) { _rank += n; return _rank; }
+
+    private:
+        const T * _object;
+        R _rank;
+        Element * _prev;
+        Element * _next;
+        unsigned int _level;
+    };
+
 
     // Grouping List Element
     template<typename T>
@@ -356,6 +433,51 @@ namespace List_Iterators
     private:
         Element * _current;
     };
+
+    // Pre-order Iterator (for pairing heaps)
+    template<typename El>
+    class Heap_Preorder
+    {
+    private:
+        typedef Heap_Preorder<El> Iterator;
+
+    public:
+        typedef El Element;
+
+    public:
+        Heap_Preorder(): _current(0) {}
+        Heap_Preorder(Element * e): _current(e) {}
+
+        operator Element *() const { return _current; }
+
+        Element & operator*() const { return *_current; }
+        Element * operator->() const { return _current; }
+
+        Iterator & operator++() {
+            if(_current->child())
+                _current = _current->child();
+            else {
+                while(_current && !_current->next())
+                    _current = parent(_current);
+                if(_current)
+                    _current = _current->next();
+            }
+            return *this;
+        }
+        Iterator operator++(int) { Iterator tmp = *this; ++*this; return tmp; }
+
+        bool operator==(const Iterator & i) const { return _current == i._current; }
+        bool operator!=(const Iterator & i) const { return _current != i._current; }
+
+    private:
+        static Element * parent(Element * e) {
+            for(; e->prev() && (e->prev()->child() != e); e = e->prev());
+            return e->prev();
+        }
+
+    private:
+        Element * _current;
+    };
 }
 
 // Singly-Linked List
@@ -968,6 +1090,27 @@ public:
         }
     }
 
+    // Moves all the elements of "list", which must be ordered by the same rank (e.g. an Ordered_Queue of the same
+    // elements), into this list in a single pass over both, keeping elements of equal rank in insertion order
+    template<typename S>
+    void merge(S * list) {
+        db<Lists>(TRC) << "Ordered_List::merge(l=" << list << ")" << endl;
+
+        Element * next = head();
+        while(!list->empty()) {
+            Element * e = list->remove();
+            for(; next && (next->rank() <= e->rank()); next = next->next());
+            if(empty())
+                insert_first(e);
+            else if(!next)
+                insert_tail(e);
+            else if(!next->prev())
+                insert_head(e);
+            else
+                Base::insert(e, next->prev(), next);
+        }
+    }
+
     Element * remove() {
         db<Lists>(TRC) << "Ordered_List::remove()" << endl;
         Element * e = Base::remove_head();
@@ -1032,23 +1175,326 @@ template<typename T = void,
 class Typed_List: public List<T, El> {};
 
 
+// Pairing Heap
+// A drop-in replacement for Ordered_List as the base of scheduling lists:
+// insert() is O(1) and remove_head() and remove() are O(log n) amortized,
+// instead of O(n) insertion. Elements with the same rank leave the heap in
+// the order they were inserted, just like in Ordered_List. tail() walks the
+// whole heap and is only meant for inspection.
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = List_Elements::Pairing_Heap_Scheduling<T, R> >
+class Pairing_Heap
+{
+public:
+    typedef T Object_Type;
+    typedef R Rank_Type;
+    typedef El Element;
+    typedef List_Iterators::Heap_Preorder<El> Iterator;
+
+public:
+    Pairing_Heap(): _size(0), _root(0), _order(0) {}
+
+    bool empty() const { return (_size == 0); }
+    unsigned long size() const { return _size; }
+
+    Element * head() { return _root; }
+    Element * tail() {
+        Element * t = _root;
+        for(Iterator i = begin(); i != end(); i++)
+            if(!before(i, t))
+                t = i;
+        return t;
+    }
+
+    Iterator begin() { return Iterator(_root); }
+    Iterator end() { return Iterator(0); }
+
+    void insert(Element * e) {
+        db<Lists>(TRC) << "Pairing_Heap::insert(e=" << e << ",o=" << (e ? e->object() : (void *) -1) << ")" << endl;
+
+        e->prev(0);
+        e->next(0);
+        e->child(0);
+        e->order(_order++);
+        _root = meld(_root, e);
+        _size++;
+    }
+
+    // Insertion is already O(1), so merging is just inserting each element of "list" (in its order)
+    template<typename S>
+    void merge(S * list) {
+        while(!list->empty())
+            insert(list->remove());
+    }
+
+    Element * remove() { return remove_head(); }
+
+    Element * remove_head() {
+        db<Lists>(TRC) << "Pairing_Heap::remove_head()" << endl;
+
+        if(empty())
+            return 0;
+
+        Element * e = _root;
+        _root = merge_pairs(e->child());
+        e->child(0);
+        _size--;
+
+        return e;
+    }
+
+    Element * remove(Element * e) {
+        db<Lists>(TRC) << "Pairing_Heap::remove(e=" << e << ",o=" << (e ? e->object() : (void *) -1) << ")" << endl;
+
+        if(e == _root)
+            return remove_head();
+
+        // Unlink e (and its subtree) from its siblings
+        if(e->prev()->child() == e)
+            e->prev()->child(e->next());
+        else
+            e->prev()->next(e->next());
+        if(e->next())
+            e->next()->prev(e->prev());
+        e->prev(0);
+        e->next(0);
+
+        _root = meld(_root, merge_pairs(e->child()));
+        e->child(0);
+        _size--;
+
+        return e;
+    }
+
+    Element * remove(const Object_Type * obj) {
+        Element * e = search(obj);
+        if(e)
+            return remove(e);
+        return 0;
+    }
+
+    Element * search(const Object_Type * obj) {
+        Iterator i = begin();
+        for(; (i != end()) && (i->object() != obj); i++);
+        return i;
+    }
+
+private:
+    static bool before(Element * a, Element * b) {
+        return (a->rank() < b->rank()) || ((a->rank() == b->rank()) && (a->order() < b->order()));
+    }
+
+    // Both a and b must be roots (i.e. have no siblings)
+    static Element * meld(Element * a, Element * b) {
+        if(!a)
+            return b;
+        if(!b)
+            return a;
+        if(before(b, a)) {
+            Element * tmp = a;
+            a = b;
+            b = tmp;
+        }
+        b->prev(a);
+        b->next(a->child());
+        if(a->child())
+            a->child()->prev(b);
+        a->child(b);
+        return a;
+    }
+
+    // Two-pass pairing of a sibling list, returning the new root
+    static Element * merge_pairs(Element * first) {
+        Element * pairs = 0; // melded pairs, most recent first, linked through next()
+        while(first) {
+            Element * a = first;
+            Element * b = a->next();
+            first = b ? b->next() : 0;
+            a->prev(0);
+            a->next(0);
+            if(b) {
+                b->prev(0);
+                b->next(0);
+            }
+            a = meld(a, b);
+            a->next(pairs);
+            pairs = a;
+        }
+
+        Element * root = 0;
+        while(pairs) {
+            Element * n = pairs->next();
+            pairs->next(0);
+            root = meld(root, pairs);
+            pairs = n;
+        }
+        if(root)
+            root->prev(0);
+
+        return root;
+    }
+
+private:
+    unsigned long _size;
+    Element * _root;
+    unsigned long _order;
+};
+
+
+// Doubly-Linked, Bitmap Ordered List
+// A drop-in replacement for Ordered_List as the base of scheduling lists
+// whose ranks are static priorities. Ranks are grouped in LEVELS levels by
+// magnitude (all negative ranks in level 0, then one level per bit length of
+// non-negative ones), each level being a FIFO-ordered run of the list whose
+// ends are tracked along with a bitmap of non-empty levels. Insertion only
+// walks the target level, so a set of distinct priority classes (e.g. HIGH,
+// NORMAL, LOW, IDLE or rate-monotonic periods) is handled in O(1), and
+// head() is always the first element of the list.
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = List_Elements::Bitmap_Scheduling<T, R> >
+class Bitmap_Ordered_List: public List<T, El>
+{
+private:
+    typedef List<T, El> Base;
+
+public:
+    typedef T Object_Type;
+    typedef R Rank_Type;
+    typedef El Element;
+    typedef List_Iterators::Bidirecional<El> Iterator;
+
+    static const unsigned int LEVELS = sizeof(int) * 8 + 1;
+
+public:
+    Bitmap_Ordered_List(): _map(0) {
+        for(unsigned int i = 0; i < LEVELS; i++)
+            _first[i] = _last[i] = 0;
+    }
+
+    using Base::empty;
+    using Base::size;
+    using Base::head;
+    using Base::tail;
+    using Base::begin;
+    using Base::end;
+    using Base::search;
+
+    void insert(Element * e) {
+        db<Lists>(TRC) << "Bitmap_Ordered_List::insert(e=" << e << ",o=" << (e ? e->object() : (void *) -1) << ")" << endl;
+
+        unsigned int l = level(e->rank());
+        e->level(l);
+
+        if(_map & (1ULL << l)) {
+            Element * stop = _last[l]->next();
+            Element * next = _first[l];
+            for(; (next != stop) && (next->rank() <= e->rank()); next = next->next());
+            if(next == stop) {
+                insert_after(e, _last[l]);
+                _last[l] = e;
+            } else {
+                insert_before(e, next);
+                if(next == _first[l])
+                    _first[l] = e;
+            }
+        } else {
+            unsigned long long above = _map & ~((2ULL << l) - 1);
+            if(above)
+                insert_before(e, _first[__builtin_ctzll(above)]);
+            else
+                Base::insert_tail(e);
+            _first[l] = _last[l] = e;
+            _map |= (1ULL << l);
+        }
+    }
+
+    // Each insertion only walks its own level, so merging is just inserting each element of "list" (in its order)
+    template<typename S>
+    void merge(S * list) {
+        while(!list->empty())
+            insert(list->remove());
+    }
+
+    Element * remove() { return remove_head(); }
+
+    Element * remove_head() {
+        Element * e = head();
+        if(e)
+            remove(e);
+        return e;
+    }
+
+    Element * remove(Element * e) {
+        db<Lists>(TRC) << "Bitmap_Ordered_List::remove(e=" << e << ",o=" << (e ? e->object() : (void *) -1) << ")" << endl;
+
+        unsigned int l = e->level();
+        if((e == _first[l]) && (e == _last[l])) {
+            _first[l] = _last[l] = 0;
+            _map &= ~(1ULL << l);
+        } else if(e == _first[l])
+            _first[l] = e->next();
+        else if(e == _last[l])
+            _last[l] = e->prev();
+
+        return Base::remove(e);
+    }
+
+    Element * remove(const Object_Type * obj) {
+        Element * e = search(obj);
+        if(e)
+            return remove(e);
+        return 0;
+    }
+
+private:
+    static unsigned int level(int rank) {
+        if(rank < 0)
+            return 0;
+        return 1 + (rank ? (sizeof(int) * 8 - __builtin_clz(rank)) : 0);
+    }
+
+    void insert_before(Element * e, Element * n) {
+        if(n->prev())
+            Base::insert(e, n->prev(), n);
+        else
+            Base::insert_head(e);
+    }
+
+    void insert_after(Element * e, Element * p) {
+        if(p->next())
+            Base::insert(e, p, p->next());
+        else
+            Base::insert_tail(e);
+    }
+
+private:
+    unsigned long long _map;
+    Element * _first[LEVELS];
+    Element * _last[LEVELS];
+};
+
+
 // Doubly-Linked, Scheduling List
 // Objects subject to scheduling must export a type "Criterion" compatible
 // with those available at scheduler.h .
 // In this implementation, the chosen element is kept outside the list
-// referenced by the _chosen attribute.
+// referenced by the _chosen attribute. The remaining elements are kept in B,
+// which can be any container with Ordered_List's interface (e.g. Pairing_Heap).
 template<typename T,
           typename R = typename T::Criterion,
-          typename El = List_Elements::Doubly_Linked_Scheduling<T, R> >
-class Scheduling_List: private Ordered_List<T, R, El>
+          typename El = List_Elements::Doubly_Linked_Scheduling<T, R>,
+          typename B = Ordered_List<T, R, El> >
+class Scheduling_List: private B
 {
-    template<typename FT, typename FR, typename FEl, unsigned int FH>
+    template<typename FT, typename FR, typename FEl, typename FB, unsigned int FH>
     friend class Multihead_Scheduling_List;     // for chosen() and remove()
     template<typename FT, typename FR, typename FEl, typename FL, unsigned int FQ>
     friend class Scheduling_Multilist;          // for chosen() and remove()
 
 private:
-    typedef Ordered_List<T, R, El> Base;
+    typedef B Base;
 
 public:
     typedef T Object_Type;
@@ -1081,6 +1527,16 @@ public:
             _chosen = e;
     }
 
+    // Inserts all the elements of "list", which must be ordered by the same criterion, at once (see Ordered_List)
+    template<typename S>
+    void merge(S * list) {
+        db<Lists>(TRC) << "Scheduling_List::merge(l=" << list << ")" << endl;
+
+        if(!_chosen && !list->empty())
+            _chosen = list->remove();
+        Base::merge(list);
+    }
+
     Element * remove(Element * e) {
         db<Lists>(TRC) << "Scheduling_List::remove(e=" << e
                        << ") => {p=" << (e ? e->prev() : (void *) -1)
@@ -1147,18 +1603,20 @@ private:
 // Besides declaring "Criterion", objects subject to scheduling policies that
 // use the Multihead list must export the HEADS constant to indicate the
 // number of heads in the list and the current_head() class method to designate
-// the head to which the current operation applies.
+// the head to which the current operation applies. As in Scheduling_List,
+// B is the container holding the elements not chosen by any head.
 template<typename T,
           typename R = typename T::Criterion,
           typename El = List_Elements::Doubly_Linked_Scheduling<T, R>,
+          typename B = Ordered_List<T, R, El>,
           unsigned int H = R::HEADS>
-class Multihead_Scheduling_List: private Ordered_List<T, R, El>
+class Multihead_Scheduling_List: private B
 {
     template<typename FT, typename FR, typename FEl, typename FL, unsigned int FQ>
     friend class Scheduling_Multilist;          // for chosen() and remove()
 
 private:
-    typedef Ordered_List<T, R, El> Base;
+    typedef B Base;
 
 public:
     typedef T Object_Type;
@@ -1180,6 +1638,7 @@ public:
     using Base::end;
 
     Element * volatile & chosen() { return _chosen[R::current_head()]; }
+    Element * chosen_at(unsigned int head) const { return _chosen[head]; }
 
     void insert(Element * e) {
         db<Lists>(TRC) << "Scheduling_List::insert(e=" << e
@@ -1194,6 +1653,16 @@ public:
             _chosen[R::current_head()] = e;
     }
 
+    // Inserts all the elements of "list", which must be ordered by the same criterion, at once (see Ordered_List)
+    template<typename S>
+    void merge(S * list) {
+        db<Lists>(TRC) << "Scheduling_List::merge(l=" << list << ")" << endl;
+
+        if(!_chosen[R::current_head()] && !list->empty())
+            _chosen[R::current_head()] = list->remove();
+        Base::merge(list);
+    }
+
     Element * remove(Element * e) {
         db<Lists>(TRC) << "Scheduling_List::remove(e=" << e
                        << ") => {p=" << (e ? e->prev() : (void *) -1)
@@ -1202,7 +1671,7 @@ public:
                        << "}" << endl;
 
         if(e == _chosen[R::current_head()])
-            _chosen[R::current_head()] = Base::remove_head();
+            _chosen[R::current_head()] = remove_first();
         else
             e = Base::remove(e);
 
@@ -1214,7 +1683,7 @@ public:
 
         if(!empty()) {
             Base::insert(_chosen[R::current_head()]);
-            _chosen[R::current_head()] = Base::remove_head();
+            _chosen[R::current_head()] = remove_first();
         }
 
         return _chosen[R::current_head()];
@@ -1223,9 +1692,10 @@ public:
     Element * choose_another() {
         db<Lists>(TRC) << "Scheduling_List::choose_another()" << endl;
 
-        if(!empty() && head()->rank() != R::IDLE) {
+        Element * e = first();
+        if(e && e->rank() != R::IDLE) {
             Element * tmp = _chosen[R::current_head()];
-            _chosen[R::current_head()] = Base::remove_head();
+            _chosen[R::current_head()] = Base::remove(e);
             Base::insert(tmp);
         }
 
@@ -1251,6 +1721,27 @@ private:
     using Base::remove;
     void chosen(Element * e) { _chosen[R::current_head()] = e; }
 
+    // The first element the current head may take: the head of B or, for criteria whose objects may be restricted
+    // to some heads (R::migrating), the first one in order that is eligible to run on it (0 if none is)
+    Element * first() {
+        if(R::migrating) {
+            for(Element * e = head(); e; e = e->next())
+                if(e->rank().eligible(R::current_head()))
+                    return e;
+            return 0;
+        }
+        return head();
+    }
+
+    Element * remove_first() {
+        if(R::migrating) {
+            Element * e = first();
+            if(e)
+                return Base::remove(e);
+        }
+        return Base::remove_head();
+    }
+
 private:
     Element * volatile _chosen[H];
 };
@@ -1298,11 +1789,19 @@ public:
     Element * volatile & chosen() {
         return _list[R::current_queue()].chosen();
     }
+    Element * chosen_at(unsigned int queue) { return _list[queue].chosen(); }
 
     void insert(Element * e) {
         _list[e->rank().queue()].insert(e);
     }
 
+    // Elements may belong to different sublists, so they are inserted one by one
+    template<typename S>
+    void merge(S * list) {
+        while(!list->empty())
+            insert(list->remove());
+    }
+
     Element * remove(Element * e) {
          return _list[e->rank().queue()].remove(e);
      }
@@ -1335,7 +1834,11 @@ public:
     }
 
 private:
-    L _list[Q];
+    // Each sublist gets its own cache line(s), so CPUs working on their own queues do not share lines
+    class Padded_List: public L {} __attribute__((aligned(Traits<CPU>::CACHE_LINE_SIZE)));
+
+private:
+    Padded_List _list[Q];
 };
 
 // Doubly-Linked, Multihead Scheduling Multilist
@@ -1351,7 +1854,7 @@ template<typename T,
           typename El = List_Elements::Doubly_Linked_Scheduling<T, R>,
           unsigned int Q = R::QUEUES,
           unsigned int H = R::HEADS>
-class Multihead_Scheduling_Multilist: public Scheduling_Multilist<T, R, El, Multihead_Scheduling_List<T, R, El, H>, Q> {};
+class Multihead_Scheduling_Multilist: public Scheduling_Multilist<T, R, El, Multihead_Scheduling_List<T, R, El, Ordered_List<T, R, El>, H>, Q> {};
 
 // Doubly-Linked, Grouping List
 template<typename T,
@@ -0,0 +1,63 @@
+// EPOS Pool Utility Declarations
+
+#ifndef __pool_h
+#define __pool_h
+
+#include <system/config.h>
+
+__BEGIN_UTIL
+
+extern "C" {
+    void _lock_heap();
+    void _unlock_heap();
+}
+
+// Pool
+// Keeps up to LIMIT released blocks of a single size in a free list linked
+// through the blocks themselves, so recycling an object is a pop or a push
+// instead of a search in the heap. get() returns 0 when the pool is empty and
+// put() returns false when it is full, leaving it to the caller to go to the
+// heap. The pool is shared by all CPUs (under the heap lock), so a block
+// released on one CPU is never stranded away from another that needs it.
+// Since every get() and put() takes that lock, pools only pay off for blocks
+// too large for the heap's per-CPU caches (e.g. thread stacks), and since
+// they don't know where a block came from, all the blocks of a pool must come
+// from the same heap.
+// Pools have no constructor and must have static storage (i.e. start zeroed).
+template<unsigned int LIMIT = 4>
+class Pool
+{
+public:
+    void * get() {
+        _lock_heap();
+        void * ptr = _free;
+        if(ptr) {
+            _free = *reinterpret_cast<void **>(ptr);
+            _count--;
+        }
+        _unlock_heap();
+        return ptr;
+    }
+
+    bool put(void * ptr) {
+        _lock_heap();
+        bool pooled = (_count < LIMIT);
+        if(pooled) {
+            *reinterpret_cast<void **>(ptr) = _free;
+            _free = ptr;
+            _count++;
+        }
+        _unlock_heap();
+        return pooled;
+    }
+
+    unsigned int size() const { return _count; }
+
+private:
+    void * _free;
+    unsigned int _count;
+};
+
+__END_UTIL
+
+#endif
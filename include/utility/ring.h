@@ -0,0 +1,151 @@
+// EPOS Lock-free Ring Buffer Utility Declarations
+
+#ifndef __ring_h
+#define __ring_h
+
+#include <architecture.h>
+
+__BEGIN_UTIL
+
+// Bounded Lock-free Ring Buffers
+// Both rings hold up to N elements of type T, copied in by insert() and out by remove(), which return false instead of
+// waiting when the ring is full or empty, respectively (see Mailbox for blocking). N must be a power of two. The
+// indices producers and consumers advance are kept in separate cache lines, so one side doesn't invalidate the other's
+// line on every operation.
+
+// Multiple Producers, Multiple Consumers
+// Each cell carries a sequence number telling whose turn it is: producers may fill cell "i" at position "p" when its
+// sequence equals "p" and consumers may empty it when it equals "p + 1". A producer (consumer) claims a position with a
+// single CAS on the tail (head) index and then owns its cell until it publishes the next sequence number, so producers
+// only contend with other producers and consumers with other consumers.
+template<typename T, unsigned int N>
+class MPMC_Ring
+{
+private:
+    static const unsigned int MASK = N - 1;
+    static const unsigned int LINE = Traits<CPU>::CACHE_LINE_SIZE;
+
+    struct Cell {
+        volatile unsigned long sequence;
+        T data;
+    };
+
+public:
+    MPMC_Ring(): _head(0), _tail(0) {
+        for(unsigned int i = 0; i < N; i++)
+            _cells[i].sequence = i;
+    }
+
+    bool insert(const T & data) {
+        Cell * cell;
+        unsigned long pos = _tail;
+        for(;;) {
+            cell = &_cells[pos & MASK];
+            long diff = long(cell->sequence) - long(pos);
+            if(diff == 0) {
+                if(CPU::cas(_tail, pos, pos + 1) == pos)
+                    break;
+                pos = _tail;
+            } else if(diff < 0)
+                return false; // full
+            else
+                pos = _tail;
+        }
+        CPU::fence();
+        cell->data = data;
+        CPU::fence();
+        cell->sequence = pos + 1;
+        return true;
+    }
+
+    bool remove(T * data) {
+        Cell * cell;
+        unsigned long pos = _head;
+        for(;;) {
+            cell = &_cells[pos & MASK];
+            long diff = long(cell->sequence) - long(pos + 1);
+            if(diff == 0) {
+                if(CPU::cas(_head, pos, pos + 1) == pos)
+                    break;
+                pos = _head;
+            } else if(diff < 0)
+                return false; // empty
+            else
+                pos = _head;
+        }
+        CPU::fence();
+        *data = cell->data;
+        CPU::fence();
+        cell->sequence = pos + N;
+        return true;
+    }
+
+    bool empty() const { return (_head == _tail); }
+    unsigned long size() const { return _tail - _head; }
+
+private:
+    volatile unsigned long _head;
+    char _head_padding[LINE - sizeof(unsigned long)];
+    volatile unsigned long _tail;
+    char _tail_padding[LINE - sizeof(unsigned long)];
+    Cell _cells[N];
+} __attribute__((aligned(Traits<CPU>::CACHE_LINE_SIZE)));
+
+// Single Producer, Single Consumer
+// Each index is only written by its own side, so neither needs atomic operations, just fences to publish the cells
+// before the indices. Each side also caches the other's index and only reads it again when the ring seems full (empty),
+// to keep from pulling the other side's cache line on every operation.
+template<typename T, unsigned int N>
+class SPSC_Ring
+{
+private:
+    static const unsigned int MASK = N - 1;
+    static const unsigned int LINE = Traits<CPU>::CACHE_LINE_SIZE;
+
+public:
+    SPSC_Ring(): _head(0), _tail_cache(0), _tail(0), _head_cache(0) {}
+
+    bool insert(const T & data) {
+        unsigned long pos = _tail;
+        if(pos - _head_cache == N) {
+            _head_cache = _head;
+            if(pos - _head_cache == N)
+                return false; // full
+        }
+        CPU::fence();
+        _data[pos & MASK] = data;
+        CPU::fence();
+        _tail = pos + 1;
+        return true;
+    }
+
+    bool remove(T * data) {
+        unsigned long pos = _head;
+        if(pos == _tail_cache) {
+            _tail_cache = _tail;
+            if(pos == _tail_cache)
+                return false; // empty
+        }
+        CPU::fence();
+        *data = _data[pos & MASK];
+        CPU::fence();
+        _head = pos + 1;
+        return true;
+    }
+
+    bool empty() const { return (_head == _tail); }
+    unsigned long size() const { return _tail - _head; }
+
+private:
+    volatile unsigned long _head;       // consumer's
+    unsigned long _tail_cache;
+    char _head_padding[LINE - 2 * sizeof(unsigned long)];
+    volatile unsigned long _tail;       // producer's
+    unsigned long _head_cache;
+    char _tail_padding[LINE - 2 * sizeof(unsigned long)];
+    T _data[N];
+} __attribute__((aligned(Traits<CPU>::CACHE_LINE_SIZE)));
+
+__END_UTIL
+
+#endif
@@ -11,9 +11,37 @@ __BEGIN_UTIL
 // the semantics of returning the desired order of a given object within the
 // scheduling list
 
+// Scheduling_Queue_Base
+// Selects the container that keeps the ready objects ordered, as given by
+// Traits<T>::scheduling_queue: a linearly ordered list (ORDERED_LIST), a
+// pairing heap for dynamic priorities such as deadlines (PAIRING_HEAP), or a
+// bitmap of priority levels for static priorities (LEVEL_BITMAP). Migrating
+// criteria always get the list, since their heads may have to look past the
+// first elements, in order, for one they are eligible to run.
+template<typename T, typename R, int B = R::migrating ? ORDERED_LIST : Traits<T>::scheduling_queue>
+struct Scheduling_Queue_Base
+{
+    typedef List_Elements::Doubly_Linked_Scheduling<T, R> Element;
+    typedef Ordered_List<T, R, Element> List;
+};
+
+template<typename T, typename R>
+struct Scheduling_Queue_Base<T, R, PAIRING_HEAP>
+{
+    typedef List_Elements::Pairing_Heap_Scheduling<T, R> Element;
+    typedef Pairing_Heap<T, R, Element> List;
+};
+
+template<typename T, typename R>
+struct Scheduling_Queue_Base<T, R, LEVEL_BITMAP>
+{
+    typedef List_Elements::Bitmap_Scheduling<T, R> Element;
+    typedef Bitmap_Ordered_List<T, R, Element> List;
+};
+
 // Scheduling_Queue
 template<typename T, typename R = typename T::Criterion>
-class Scheduling_Queue: public Multihead_Scheduling_List<T> {};
+class Scheduling_Queue: public Multihead_Scheduling_List<T, R, typename Scheduling_Queue_Base<T, R>::Element, typename Scheduling_Queue_Base<T, R>::List> {};
 
 
 // Scheduler
@@ -49,6 +77,11 @@ public:
             return const_cast<T * volatile>(Base::chosen()->object());
     }
 
+    // The object chosen by a given head (or queue, for partitioned lists), usually the one running on that CPU
+    T * chosen_at(unsigned int head) {
+        return Base::chosen_at(head) ? Base::chosen_at(head)->object() : 0;
+    }
+
     void insert(T * obj) {
         db<Scheduler>(TRC) << "Scheduler[chosen=" << chosen() << "]::insert(" << obj << ")" << endl;
 
@@ -73,6 +106,14 @@ public:
         Base::insert(obj->link());
     }
 
+    // Resumes all the objects in "queue" (e.g. a waiting queue ordered by the same criterion) at once
+    template<typename Q>
+    void resume_all(Q * queue) {
+        db<Scheduler>(TRC) << "Scheduler[chosen=" << chosen() << "]::resume_all(" << queue << ")" << endl;
+
+        Base::merge(queue);
+    }
+
     T * choose() {
         db<Scheduler>(TRC) << "Scheduler[chosen=" << chosen() << "]::choose() => ";
 
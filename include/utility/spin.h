@@ -9,16 +9,38 @@ extern "C" { volatile unsigned long _running(); }
 
 __BEGIN_UTIL
 
+// Spin locks come in two flavors, as given by Traits<Spin>::algorithm:
+// TEST_AND_SET: waiters keep trying to swap themselves into the lock word, so the lock goes to whoever gets there
+//               first after a release (not necessarily the one waiting the longest), and every attempt is a write
+//               that bounces the cache line among the waiting CPUs.
+// TICKET:       waiters take a ticket (a single atomic increment) and then only read the "now serving" counter,
+//               which the holder increments on release, so the lock is handed over in FIFO order and the line is
+//               only written once per acquisition and once per hand-over, however many CPUs are waiting. Neither
+//               the increment nor the counter accesses order memory by themselves, so the lock fences after taking
+//               its turn and before handing it over, otherwise weakly ordered CPUs (e.g. RISC-V) could move accesses
+//               out of the critical section.
+
 // Recursive Spin Lock
 class Spin
 {
+private:
+    static const bool ticket = (Traits<Spin>::algorithm == Spin_Lock_Algorithm::TICKET);
+
 public:
-    Spin(): _level(0), _owner(0) {}
+    Spin(): _level(0), _owner(0), _next(0), _serving(0) {}
 
     void acquire() {
         unsigned long me = _running();
 
-        while(CPU::cas(_owner, 0UL, me) != me);
+        if(ticket) {
+            if(_owner != me) { // only we could have set it to us
+                unsigned long turn = CPU::finc(_next);
+                while(_serving != turn);
+                CPU::fence(); // acquire: nothing in the critical section may be performed before we got the lock
+                _owner = me;
+            }
+        } else
+            while(CPU::cas(_owner, 0UL, me) != me);
         _level++;
 
         db<Spin>(TRC) << "Spin::acquire[this=" << this << ",id=" << hex << me << "]() => {owner=" << _owner << dec << ",level=" << _level << "}" << endl;
@@ -30,6 +52,10 @@ public:
         if(--_level <= 0) {
     	    _level = 0;
             _owner = 0;
+            if(ticket) {
+                CPU::fence(); // release: everything in the critical section must be visible before the hand-over
+                _serving++;
+            }
     	}
     }
 
@@ -43,28 +69,44 @@ public:
 private:
     volatile long _level;
     volatile unsigned long _owner;
+    volatile unsigned long _next;
+    volatile unsigned long _serving;
 };
 
 // Flat Spin Lock
 class Simple_Spin
 {
+private:
+    static const bool ticket = (Traits<Spin>::algorithm == Spin_Lock_Algorithm::TICKET);
+
 public:
-    Simple_Spin(): _locked(false) {}
+    Simple_Spin(): _locked(false), _next(0), _serving(0) {}
 
     void acquire() {
-        while(CPU::tsl(_locked));
+        if(ticket) {
+            unsigned long turn = CPU::finc(_next);
+            while(_serving != turn);
+            CPU::fence();
+        } else
+            while(CPU::tsl(_locked));
 
         db<Spin>(TRC) << "Spin::acquire[SPIN=" << this << "]()" << endl;
     }
 
     void release() {
-        _locked = 0;
+        if(ticket) {
+            CPU::fence();
+            _serving++;
+        } else
+            _locked = 0;
 
         db<Spin>(TRC) << "Spin::release[SPIN=" << this << "]()}" << endl;
     }
 
 private:
     volatile bool _locked;
+    volatile unsigned long _next;
+    volatile unsigned long _serving;
 };
 
 __END_UTIL
@@ -0,0 +1,212 @@
+// EPOS Timing Wheel Utility Declarations
+
+#ifndef __wheel_h
+#define __wheel_h
+
+#include <system/config.h>
+#include "list.h"
+
+__BEGIN_UTIL
+
+// Hierarchical Timing Wheel
+// Elements are ranked by their absolute expiration time and kept in one of L
+// levels of 2^B slots each. An element lives at the level of the most
+// significant group of B bits in which its rank differs from the wheel's
+// current time (now) and in the slot given by that group of its rank, so
+// insert() and remove() are O(1). Elements too far in the future wait in an
+// overflow list. As advance() moves now forward, the slots it enters in the
+// upper levels get cascaded down, and the elements whose ranks are reached are
+// moved to an expired list, from which they are collected by remove_expired().
+// A bitmap per level keeps next(), the time advance() has work to do, O(L).
+template<typename T,
+          typename R = List_Element_Rank,
+          typename El = List_Elements::Doubly_Linked_Ordered<T, R>,
+          unsigned int B = 6,
+          unsigned int L = 4>
+class Timing_Wheel
+{
+private:
+    typedef List<T, El> Slot;
+    typedef unsigned long long Map;
+
+public:
+    typedef T Object_Type;
+    typedef R Rank_Type;
+    typedef El Element;
+
+    static const unsigned int SLOTS = 1 << B;
+    static const unsigned int LEVELS = L;
+
+public:
+    Timing_Wheel(const R & now = 0): _now(now), _size(0) {
+        for(unsigned int i = 0; i < L; i++)
+            _map[i] = 0;
+    }
+
+    bool empty() const { return (_size == 0); }
+    unsigned long size() const { return _size; }
+
+    const R & now() const { return _now; }
+
+    // Expiration time is e->rank(); elements ranked at or before now expire right away
+    void insert(Element * e) {
+        db<Lists>(TRC) << "Timing_Wheel::insert(e=" << e << ",r=" << e->rank() << ") => {now=" << _now << "}" << endl;
+
+        place(e);
+        _size++;
+    }
+
+    // Returns 0 if "e" is not in the wheel
+    Element * remove(Element * e) {
+        db<Lists>(TRC) << "Timing_Wheel::remove(e=" << e << ",r=" << e->rank() << ") => {now=" << _now << "}" << endl;
+
+        unsigned int level;
+        Slot * slot = locate(e, &level);
+        if(!e->prev() && !e->next() && (slot->head() != e))
+            return 0;
+
+        unlink(slot, e);
+        if((level < L) && slot->empty())
+            _map[level] &= ~(Map(1) << index(e->rank(), level));
+        _size--;
+
+        return e;
+    }
+
+    Element * remove_expired() {
+        if(_expired.empty())
+            return 0;
+
+        Element * e = _expired.head();
+        unlink(&_expired, e);
+        _size--;
+
+        return e;
+    }
+
+    // Moves now forward to "time", stopping at every slot in between that holds elements to cascade or expire
+    void advance(const R & time) {
+        while(_now < time) {
+            R event = next_event();
+            if(event > time) {
+                _now = time;
+                break;
+            }
+
+            _now = event;
+
+            if(!_overflow.empty() && !(_now & (span(L) - 1))) {
+                Slot overflow;
+                move(&_overflow, &overflow);
+                replace(&overflow);
+            }
+
+            for(unsigned int level = L - 1; level > 0; level--) {
+                unsigned int i = index(_now, level);
+                if(_map[level] & (Map(1) << i)) {
+                    Slot cascade;
+                    move(&_slots[level][i], &cascade);
+                    _map[level] &= ~(Map(1) << i);
+                    replace(&cascade);
+                }
+            }
+
+            unsigned int i = index(_now, 0);
+            if(_map[0] & (Map(1) << i)) {
+                move(&_slots[0][i], &_expired);
+                _map[0] &= ~(Map(1) << i);
+            }
+        }
+    }
+
+    // The earliest time at which advance() has work to do: now if there are expired
+    // elements, or the next expiration or cascade otherwise. Undefined if empty().
+    R next() const {
+        if(!_expired.empty())
+            return _now;
+
+        return next_event();
+    }
+
+private:
+    static R span(unsigned int level) { return R(1) << (level * B); }
+    static unsigned int index(const R & time, unsigned int level) { return (time >> (level * B)) & (SLOTS - 1); }
+
+    // The level in which an element ranked "time" is kept (L for the overflow list)
+    unsigned int level(const R & time) const {
+        unsigned long long diff = time ^ _now;
+        unsigned int msb = sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(diff);
+        unsigned int level = msb / B;
+        return (level < L) ? level : L;
+    }
+
+    Slot * locate(Element * e, unsigned int * l) {
+        if(e->rank() <= _now) {
+            *l = L + 1;
+            return &_expired;
+        }
+
+        *l = level(e->rank());
+        return (*l < L) ? &_slots[*l][index(e->rank(), *l)] : &_overflow;
+    }
+
+    void place(Element * e) {
+        unsigned int level;
+        Slot * slot = locate(e, &level);
+        slot->insert(e);
+        if(level < L)
+            _map[level] |= Map(1) << index(e->rank(), level);
+    }
+
+    void replace(Slot * from) {
+        while(!from->empty()) {
+            Element * e = from->head();
+            unlink(from, e);
+            place(e);
+        }
+    }
+
+    static void move(Slot * from, Slot * to) {
+        while(!from->empty()) {
+            Element * e = from->head();
+            unlink(from, e);
+            to->insert(e);
+        }
+    }
+
+    static void unlink(Slot * slot, Element * e) {
+        slot->remove(e);
+        e->prev(0);
+        e->next(0);
+    }
+
+    // Earliest slot to cascade or expire (elements always sit in slots ahead of now's in their level)
+    R next_event() const {
+        R next = ~(R(1) << (sizeof(R) * 8 - 1)); // never
+        if(!_overflow.empty())
+            next = ((_now >> (L * B)) + 1) << (L * B);
+
+        for(unsigned int level = 0; level < L; level++) {
+            if(!_map[level])
+                continue;
+            R base = (_now >> ((level + 1) * B)) << ((level + 1) * B);
+            R time = base | (R(__builtin_ctzll(_map[level])) << (level * B));
+            if(time < next)
+                next = time;
+        }
+
+        return next;
+    }
+
+private:
+    R _now;
+    unsigned long _size;
+    Map _map[L];
+    Slot _slots[L][SLOTS];
+    Slot _overflow;
+    Slot _expired;
+};
+
+__END_UTIL
+
+#endif
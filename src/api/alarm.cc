@@ -9,69 +9,77 @@ __BEGIN_SYS
 
 Alarm_Timer * Alarm::_timer;
 volatile Alarm::Tick Alarm::_elapsed;
-Alarm::Queue Alarm::_request;
-Spin Alarm::_lock;
+Alarm::Queue Alarm::_request[QUEUES];
+Spin Alarm::_lock[QUEUES];
 
 
-Alarm::Alarm(const Microsecond & time, Handler * handler, unsigned int times)
-: _time(time), _handler(handler), _times(times), _ticks(ticks(time)), _link(this, _ticks)
+Alarm::Alarm(const Microsecond & time, Handler * handler, unsigned int times, unsigned int cpu)
+: _time(time), _handler(handler), _sleeping(0), _times(times), _ticks(ticks(time)), _queue((QUEUES > 1) ? cpu % QUEUES : 0), _link(this, _ticks)
 {
-    lock();
+    lock(_queue);
 
-    db<Alarm>(TRC) << "Alarm(t=" << time << ",tk=" << _ticks << ",h=" << reinterpret_cast<void *>(handler) << ",x=" << times << ") => " << this << endl;
+    db<Alarm>(TRC) << "Alarm(t=" << time << ",tk=" << _ticks << ",h=" << reinterpret_cast<void *>(handler) << ",x=" << times << ",q=" << _queue << ") => " << this << endl;
 
     if(_ticks) {
-        _request.insert(&_link);
-        unlock();
+        enqueue();
+        unlock(_queue);
     } else {
         assert(times == 1);
-        unlock();
+        unlock(_queue);
         (*handler)();
     }
 }
 
+// Must be called with the lock of "sleeping" held and a delay of at least one tick
+Alarm::Alarm(const Microsecond & time, Thread::Queue * sleeping)
+: _time(time), _handler(0), _sleeping(sleeping), _times(1), _ticks(ticks(time)), _queue((QUEUES > 1) ? CPU::id() : 0), _link(this, _ticks)
+{
+    assert(_ticks);
+
+    lock(_queue);
+
+    db<Alarm>(TRC) << "Alarm(t=" << time << ",tk=" << _ticks << ",s=" << sleeping << ",q=" << _queue << ") => " << this << endl;
+
+    enqueue();
+
+    unlock(_queue);
+}
+
 Alarm::~Alarm()
 {
-    lock();
+    lock(_queue);
 
     db<Alarm>(TRC) << "~Alarm(this=" << this << ")" << endl;
 
-    _request.remove(this);
+    _request[_queue].remove(&_link);
 
-    unlock();
+    unlock(_queue);
 }
 
 void Alarm::reset()
 {
-    bool locked = Thread::locked();
-    if(!locked)
-        lock();
+    lock(_queue);
 
     db<Alarm>(TRC) << "Alarm::reset(this=" << this << ")" << endl;
 
-    _request.remove(this);
-    _link.rank(_ticks);
-    _request.insert(&_link);
+    _request[_queue].remove(&_link);
+    enqueue();
 
-    if(!locked)
-        unlock();
+    unlock(_queue);
 }
 
 void Alarm::period(const Microsecond & p)
 {
-    bool locked = Thread::locked();
-    if(!locked)
-        lock();
+    lock(_queue);
 
     db<Alarm>(TRC) << "Alarm::period(this=" << this << ",p=" << p << ")" << endl;
 
-    _request.remove(this);
+    _request[_queue].remove(&_link);
     _time = p;
     _ticks = ticks(p);
-    _request.insert(&_link);
+    enqueue();
 
-    if(!locked)
-        unlock();
+    unlock(_queue);
 }
 
 
@@ -79,20 +87,53 @@ void Alarm::delay(const Microsecond & time)
 {
     db<Alarm>(TRC) << "Alarm::delay(time=" << time << ")" << endl;
 
-    Semaphore semaphore(0);
-    Semaphore_Handler handler(&semaphore);
-    Alarm alarm(time, &handler, 1); // if time < tick trigger v()
-    semaphore.p();
+    if(!ticks(time)) // shorter than a tick, so the alarm would go off right away
+        return;
+
+    // The calling thread parks itself on the alarm (through a queue of its own), with no synchronizer nor handler
+    // involved. The queue's lock is held from before the alarm gets enqueued until the thread is asleep, so the alarm
+    // can't go off in between, and handler() holds it while waking the thread up, so the thread can't return (and
+    // destroy it) before handler() is done with it.
+    Thread::Queue sleeping;
+    Thread::lock(sleeping.lock());
+    Alarm alarm(time, &sleeping);
+    Thread::sleep(&sleeping);
+    Thread::unlock(sleeping.lock());
+}
+
+
+// Must be called with the lock of the alarm's queue held
+void Alarm::enqueue()
+{
+    _link.rank(elapsed() + _ticks);
+    _request[_queue].insert(&_link);
+
+    if(Timer::tickless)
+        program(_queue);
+}
+
+// Programs the timer of the CPU handling queue "q" for its next expiration (or cascade) (tickless mode only)
+void Alarm::program(unsigned int q)
+{
+    if(_request[q].empty())
+        _timer->stop(q);
+    else
+        _timer->program(_request[q].next(), q);
 }
 
 
 void Alarm::handler(IC::Interrupt_Id i)
 {
-    lock();
+    unsigned int q = (QUEUES > 1) ? CPU::id() : 0;
+
+    lock(q);
 
-    _elapsed++;
+    // Without a tickless timer, time is counted by CPU 0, so the other CPUs see it up to a tick late
+    Tick now = Timer::tickless ? elapsed() : (CPU::id() == 0) ? _elapsed + 1 : _elapsed;
+    if(CPU::id() == 0)
+        _elapsed = now;
 
-    if(Traits<Alarm>::visible) {
+    if(Traits<Alarm>::visible && (CPU::id() == 0)) {
         Display display;
         int lin, col;
         display.position(&lin, &col);
@@ -101,29 +142,46 @@ void Alarm::handler(IC::Interrupt_Id i)
         display.position(lin, col);
     }
 
-    Alarm * alarm = 0;
-
-    if(!_request.empty()) {
-        // Replacing the following "if" by a "while" loop is tempting, but recovering the lock and dispatching the handler is
-        // troublesome if the Alarm gets destroyed in between, like is the case for the idle thread returning to shutdown the machine
-        if(_request.head()->promote() <= 0) { // rank can be negative whenever multiple handlers get created for the same time tick
-            Queue::Element * e = _request.remove();
-            alarm = e->object();
-            if(alarm->_times != INFINITE)
-                alarm->_times--;
-            if(alarm->_times > 0) {
-                e->rank(alarm->_ticks);
-                _request.insert(e);
-            }
+    _request[q].advance(now);
+
+    // All alarms due by now are handled in this interrupt, so periodic threads sharing a period get released together.
+    // The lock is released around each handler, which might destroy its own Alarm (e.g. the idle thread returning to
+    // shutdown the machine) or any other. That is safe since nothing of an alarm is touched after its handler gets called
+    // and any alarm destroyed in between is also removed from the queue's expired list. Since unlocking might also
+    // dispatch another thread (e.g. one just woken up), leaving the remaining expired alarms to whenever this one runs
+    // again, a tickless timer is reprogrammed before each handler, so it fires right away for any alarms left.
+    for(Queue::Element * e = _request[q].remove_expired(); e; e = _request[q].remove_expired()) {
+        Alarm * alarm = e->object();
+        Handler * h = alarm->_handler;
+        Thread::Queue * sleeping = alarm->_sleeping;
+
+        if(alarm->_times != INFINITE)
+            alarm->_times--;
+        if(alarm->_times > 0) {
+            e->rank(e->rank() + alarm->_ticks); // reinserting from the previous expiration keeps periods from drifting
+            _request[q].insert(e);
         }
-    }
 
-    unlock();
+        if(Timer::tickless)
+            program(q);
+
+        unlock(q);
+
+        db<Alarm>(TRC) << "Alarm::handler(this=" << alarm << ",e=" << now << ",h=" << reinterpret_cast<void*>(h) << ")" << endl;
+        if(sleeping) {
+            Thread::lock(sleeping->lock());
+            Thread::wakeup(sleeping);
+            Thread::unlock(sleeping->lock());
+        } else
+            (*h)();
 
-    if(alarm) {
-        db<Alarm>(TRC) << "Alarm::handler(this=" << alarm << ",e=" << _elapsed << ",h=" << reinterpret_cast<void*>(alarm->handler) << ")" << endl;
-        (*alarm->_handler)();
+        lock(q);
     }
+
+    if(Timer::tickless)
+        program(q);
+
+    unlock(q);
 }
 
 __END_SYS
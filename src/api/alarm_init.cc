@@ -9,7 +9,18 @@ void Alarm::init()
 {
     db<Init, Alarm>(TRC) << "Alarm::init()" << endl;
 
-    _timer = new (SYSTEM) Alarm_Timer(handler);
+    if(Traits<Alarm>::high_resolution && !high_resolution)
+        db<Init, Alarm>(WRN) << "Alarm::init: high resolution alarms require a tickless timer (see Traits<Timer>::tickless)!" << endl;
+
+    _timer = new (SYSTEM) Alarm_Timer(handler, high_resolution ? Timer::CLOCK : Traits<Timer>::FREQUENCY, QUEUES > 1);
+
+    // Tickless timers count from the last reset of the machine's timer, not from now
+    if(Timer::tickless) {
+        Tick now = elapsed();
+        _elapsed = now;
+        for(unsigned int q = 0; q < QUEUES; q++)
+            _request[q].advance(now);
+    }
 }
 
 __END_SYS
@@ -0,0 +1,83 @@
+// EPOS Barrier Implementation
+
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+Barrier::Barrier(unsigned int participants, unsigned int spin): _participants(participants), _spin(spin), _sense(false)
+{
+    db<Synchronizer>(TRC) << "Barrier(participants=" << participants << ",spin=" << spin << ") => " << this << endl;
+
+    // Participants are spread as evenly as possible among the CPUs (and CPUs expecting none take no part at the root)
+    unsigned int leaves = (participants < CPUS) ? participants : CPUS;
+    for(unsigned int i = 0; i < CPUS; i++) {
+        _leaves[i].count = 0;
+        _leaves[i].expected = (i < leaves) ? (participants / leaves + ((i < participants % leaves) ? 1 : 0)) : 0;
+    }
+    _root.count = 0;
+    _root.expected = leaves;
+}
+
+
+Barrier::~Barrier()
+{
+    db<Synchronizer>(TRC) << "~Barrier(this=" << this << ")" << endl;
+}
+
+
+bool Barrier::wait()
+{
+    db<Synchronizer>(TRC) << "Barrier::wait(this=" << this << ")" << endl;
+
+    bool sense = _sense;
+    if(arrive())
+        return true;
+
+    for(unsigned int i = 0; (i < _spin) && (_sense == sense); i++);
+
+    if(_sense == sense) {
+        begin_atomic();
+        while(_sense == sense)
+            sleep();
+        end_atomic();
+    }
+
+    return false;
+}
+
+
+bool Barrier::arrive()
+{
+    db<Synchronizer>(TRC) << "Barrier::arrive(this=" << this << ")" << endl;
+
+    // There is always room left in some leaf, since there are never more arrivals than participants
+    unsigned int leaf = CPU::id() % CPUS;
+    long count;
+    while((count = finc(_leaves[leaf].count)) >= _leaves[leaf].expected)
+        leaf = (leaf + 1) % CPUS;
+
+    if(count < _leaves[leaf].expected - 1)
+        return false;
+
+    if(finc(_root.count) < _root.expected - 1)
+        return false;
+
+    release();
+    return true;
+}
+
+
+void Barrier::release()
+{
+    for(unsigned int i = 0; i < CPUS; i++)
+        _leaves[i].count = 0;
+    _root.count = 0;
+    CPU::fence(); // threads polling the sense must find the counters reset for the next round
+
+    begin_atomic();
+    _sense = !_sense;
+    wakeup_all();
+    end_atomic();
+}
+
+__END_SYS
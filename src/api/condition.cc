@@ -2,12 +2,9 @@
 
 #include <synchronizer.h>
 
-// This is actually no Condition Variable
-// check http://www.cs.duke.edu/courses/spring01/cps110/slides/sem/sld002.htm
-
 __BEGIN_SYS
 
-Condition::Condition(): Synchronizer_Common(1)
+Condition::Condition(): _mutex(0)
 {
     db<Synchronizer>(TRC) << "Condition() => " << this << endl;
 }
@@ -29,12 +26,30 @@ void Condition::wait()
 }
 
 
+void Condition::wait(Mutex & mutex)
+{
+    db<Synchronizer>(TRC) << "Condition::wait(this=" << this << ",mutex=" << &mutex << ")" << endl;
+
+    // Holding the condition's lock, no signal can get in between releasing the mutex and sleeping
+    begin_atomic();
+    _mutex = &mutex;
+    mutex.unlock();
+    sleep();
+    end_atomic();
+
+    mutex.reacquire();
+}
+
+
 void Condition::signal()
 {
     db<Synchronizer>(TRC) << "Condition::signal(this=" << this << ")" << endl;
 
     begin_atomic();
-    wakeup();
+    if(_mutex)
+        _mutex->morph(&_queue, false);
+    else
+        wakeup();
     end_atomic();
 }
 
@@ -44,7 +59,10 @@ void Condition::broadcast()
     db<Synchronizer>(TRC) << "Condition::broadcast(this=" << this << ")" << endl;
 
     begin_atomic();
-    wakeup_all();
+    if(_mutex)
+        _mutex->morph(&_queue, true);
+    else
+        wakeup_all();
     end_atomic();
 }
 
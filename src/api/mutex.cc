@@ -4,12 +4,18 @@
 
 __BEGIN_SYS
 
-Mutex::Mutex(): Synchronizer_Common(1), _locked(false)
+Mutex::Mutex(): _state(FREE), _owner(0)
 {
     db<Synchronizer>(TRC) << "Mutex() => " << this << endl;
 }
 
 
+Mutex::Mutex(const Criterion & ceiling): Synchronizer_Common(ceiling.ceiling(), true), _state(FREE), _owner(0)
+{
+    db<Synchronizer>(TRC) << "Mutex(ceiling=" << _ceiling << ") => " << this << endl;
+}
+
+
 Mutex::~Mutex()
 {
     db<Synchronizer>(TRC) << "~Mutex(this=" << this << ")" << endl;
@@ -20,11 +26,30 @@ void Mutex::lock()
 {
     db<Synchronizer>(TRC) << "Mutex::lock(this=" << this << ")" << endl;
 
+    if(fast_path) {
+        if((cas(_state, FREE, LOCKED) == FREE) || (spin() && (cas(_state, FREE, LOCKED) == FREE))) {
+            _owner = running();
+            return;
+        }
+
+        // Whoever gets the mutex from here on can't tell whether there are still waiters, so it must assume so
+        begin_atomic();
+        while(fas(_state, CONTENDED) != FREE)
+            sleep();
+        _owner = running();
+        end_atomic();
+        return;
+    }
+
+    if(_state != FREE)
+        spin();
+
     begin_atomic();
-    if(tsl(_locked)) {
+    if(cas(_state, FREE, LOCKED) != FREE) {
         apply_new_priority();
         sleep();
     }
+    _owner = running();
     insert();
     end_atomic();
 }
@@ -34,12 +59,75 @@ void Mutex::unlock()
 {
     db<Synchronizer>(TRC) << "Mutex::unlock(this=" << this << ")" << endl;
 
+    _owner = 0;
+
+    if(fast_path) {
+        if(fas(_state, FREE) == LOCKED)
+            return;
+
+        begin_atomic();
+        wakeup();
+        end_atomic();
+        return;
+    }
+
     begin_atomic();
     restore_priority();
     if(_queue.empty())
-        _locked = false;
-    else
+        _state = FREE;
+    else {
+        _owner = _queue.head()->object(); // ownership is handed over to the awakened thread
         wakeup();
+    }
+    end_atomic();
+}
+
+
+void Mutex::morph(Queue * from, bool all)
+{
+    db<Synchronizer>(TRC) << "Mutex::morph(this=" << this << ",from=" << from << ",all=" << all << ")" << endl;
+
+    begin_atomic();
+    bool awakened = false;
+    while(!from->empty()) {
+        bool held;
+        if(fast_path) {
+            // A waiter can only be left for unlock() to awaken if unlock() is sure to take the slow path
+            long state;
+            do state = _state; while((state == LOCKED) && (cas(_state, LOCKED, CONTENDED) != LOCKED));
+            held = (state != FREE);
+        } else
+            held = (_state != FREE);
+
+        if(!held && !awakened) {
+            wakeup(from);
+            awakened = true; // and it will contend (and later unlock) the mutex, so the others can wait for it
+        } else
+            apply_new_priority(requeue(from));
+
+        if(!all)
+            break;
+    }
+    end_atomic();
+}
+
+
+void Mutex::reacquire()
+{
+    db<Synchronizer>(TRC) << "Mutex::reacquire(this=" << this << ")" << endl;
+
+    begin_atomic();
+    if(fast_path) {
+        while(fas(_state, CONTENDED) != FREE)
+            sleep();
+    } else {
+        if((_owner != running()) && (cas(_state, FREE, LOCKED) != FREE)) {
+            apply_new_priority();
+            sleep();
+        }
+        insert();
+    }
+    _owner = running();
     end_atomic();
 }
 
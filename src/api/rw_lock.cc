@@ -0,0 +1,84 @@
+// EPOS Reader-Writer Lock Implementation
+
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+RW_Lock::RW_Lock(): _readers_queue(this, _queue.lock()), _readers(0), _writing(false)
+{
+    db<Synchronizer>(TRC) << "RW_Lock() => " << this << endl;
+}
+
+
+RW_Lock::~RW_Lock()
+{
+    db<Synchronizer>(TRC) << "~RW_Lock(this=" << this << ")" << endl;
+
+    begin_atomic();
+    wakeup_all(&_readers_queue);
+    end_atomic();
+}
+
+
+void RW_Lock::lock_read()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::lock_read(this=" << this << ",readers=" << _readers << ")" << endl;
+
+    begin_atomic();
+    if(_writing || !_queue.empty()) {
+        apply_new_priority();
+        sleep(&_readers_queue); // counted in _readers by whoever wakes us up
+    } else
+        _readers++;
+    insert();
+    end_atomic();
+}
+
+
+void RW_Lock::unlock_read()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::unlock_read(this=" << this << ",readers=" << _readers << ")" << endl;
+
+    begin_atomic();
+    restore_priority();
+    if((--_readers == 0) && !_queue.empty()) {
+        _writing = true;
+        wakeup();
+    }
+    end_atomic();
+}
+
+
+void RW_Lock::lock_write()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::lock_write(this=" << this << ",readers=" << _readers << ")" << endl;
+
+    begin_atomic();
+    if(_writing || _readers) {
+        apply_new_priority();
+        sleep();
+    } else
+        _writing = true;
+    insert();
+    end_atomic();
+}
+
+
+void RW_Lock::unlock_write()
+{
+    db<Synchronizer>(TRC) << "RW_Lock::unlock_write(this=" << this << ")" << endl;
+
+    begin_atomic();
+    restore_priority();
+    if(!_readers_queue.empty() && (_queue.empty() || (_readers_queue.head()->rank() < _queue.head()->rank()))) {
+        _writing = false;
+        _readers += _readers_queue.size();
+        wakeup_all(&_readers_queue);
+    } else if(!_queue.empty())
+        wakeup(); // the lock is handed over to the awakened writer
+    else
+        _writing = false;
+    end_atomic();
+}
+
+__END_SYS
@@ -5,38 +5,191 @@
 
 __BEGIN_SYS
 
+volatile unsigned int Variable_Queue_Scheduler::_next_queue;
+unsigned long SPEDF::_utilization[Traits<Machine>::CPUS];
+Simple_Spin SPEDF::_lock;
+
 // The following Scheduling Criteria depend on Alarm, which is not available at scheduler.h
 template <typename ... Tn>
-FCFS::FCFS(int p, Tn & ... an): Priority((p == IDLE) ? IDLE : Alarm::elapsed()) {}
+FCFS::FCFS(int p, Tn & ... an): Priority((p == IDLE) ? IDLE : Alarm::scheduling_elapsed()) {}
 
-EDF::EDF(const Microsecond & d, const Microsecond & p, const Microsecond & c, unsigned int): Real_Time_Scheduler_Common(Alarm::ticks(d), Alarm::ticks(d), p, c) {}
+EDF::EDF(const Microsecond & d, const Microsecond & p, const Microsecond & c, unsigned int): Real_Time_Scheduler_Common(Alarm::scheduling_ticks(d), Alarm::scheduling_ticks(d), p, c) {}
 
 void EDF::update() {
-    if (_priority == CEILING) {
+    if (_protocol_applied) {
         if ((_frozen_priority >= PERIODIC) && (_frozen_priority < APERIODIC))
-            _frozen_priority = Alarm::elapsed() + _deadline;
+            _frozen_priority = Alarm::scheduling_elapsed() + _deadline;
     } else if((_priority >= PERIODIC) && (_priority < APERIODIC))
-        _priority = Alarm::elapsed() + _deadline;
+        _priority = Alarm::scheduling_elapsed() + _deadline;
+}
+
+int EDF::ceiling() const {
+    int p = base_priority();
+    return ((p >= PERIODIC) && (p < APERIODIC)) ? int(_deadline) : int(IDLE);
+}
+
+int EDF::ceiling_priority(int ceiling) {
+    return ((ceiling >= PERIODIC) && (ceiling < APERIODIC)) ? int(Alarm::scheduling_elapsed() + ceiling) : ceiling;
 }
 
 LLF::LLF(const Microsecond & d, const Microsecond & wcet, const Microsecond & p, const Microsecond & c, unsigned int): 
-    Real_Time_Scheduler_Common(Alarm::ticks(d) - Alarm::ticks(wcet), Alarm::ticks(d), p, c),
-    _wcet(Alarm::ticks(wcet)) {}
+    Real_Time_Scheduler_Common(Alarm::scheduling_ticks(d) - Alarm::scheduling_ticks(wcet), Alarm::scheduling_ticks(d), p, c),
+    _wcet(Alarm::scheduling_ticks(wcet)) {}
 
 void LLF::update() {
-    if (_priority == CEILING) {
+    if (_protocol_applied) {
         if ((_frozen_priority >= PERIODIC) && (_frozen_priority < APERIODIC))
-            _frozen_priority = Alarm::elapsed() + _deadline - _wcet;
+            _frozen_priority = Alarm::scheduling_elapsed() + _deadline - _wcet;
     } else if((_priority >= PERIODIC) && (_priority < APERIODIC))
-        _priority = Alarm::elapsed() + _deadline - _wcet;
+        _priority = Alarm::scheduling_elapsed() + _deadline - _wcet;
+}
+
+int LLF::ceiling() const {
+    int p = base_priority();
+    return ((p >= PERIODIC) && (p < APERIODIC)) ? int(_deadline - _wcet) : int(IDLE);
 }
 
 void LLF::update_on_reschedule(const Microsecond & exec_start) {
-    if (_priority == CEILING) {
+    if (_protocol_applied) {
         if ((_frozen_priority >= PERIODIC) && (_frozen_priority < APERIODIC))
-            _frozen_priority += Alarm::elapsed() - exec_start;
+            _frozen_priority += Alarm::scheduling_elapsed() - exec_start;
     } else if((_priority >= PERIODIC) && (_priority < APERIODIC))
-        _priority += Alarm::elapsed() - exec_start;
+        _priority += Alarm::scheduling_elapsed() - exec_start;
+}
+
+SPEDF::SPEDF(const Microsecond & d, const Microsecond & p, const Microsecond & c, unsigned int cpu)
+: EDF(d, p, c, cpu), Variable_Queue_Scheduler((cpu == ANY) ? 0 : cpu), _budget(0), _executed(0), _share(0), _split_share(0) {
+    Microsecond t = p ? p : d;
+    if(!c || !t) {
+        if(cpu == ANY)
+            _queue = CPU::finc(_next_queue) % QUEUES;
+    } else {
+        // Threads may be created on several CPUs at once, and a thread holding the lock must not be preempted by
+        // one that would spin on it forever
+        bool enabled = CPU::int_enabled();
+        CPU::int_disable();
+        _lock.acquire();
+
+        if(cpu == ANY)
+            partition(c, t);
+        else {
+            _share = (unsigned long long)(c) * UNIT / t;
+            _utilization[_queue] += _share;
+        }
+
+        _lock.release();
+        if(enabled)
+            CPU::int_enable();
+    }
+    _first = _queue;
+    if(!_budget)
+        _second = _queue;
+}
+
+// Gives the thread's share of its CPUs back, so threads created later may use it (called when the thread is destroyed;
+// criteria are copied around by value, so this can't be the destructor)
+void SPEDF::retire()
+{
+    if(!_share && !_split_share)
+        return;
+
+    bool enabled = CPU::int_enabled();
+    CPU::int_disable();
+    _lock.acquire();
+
+    _utilization[_first] -= _share;
+    _utilization[_second] -= _split_share;
+    _share = 0;
+    _split_share = 0;
+
+    _lock.release();
+    if(enabled)
+        CPU::int_enable();
+}
+
+// First fit: the thread goes to the first CPU that still has room for its utilization (c / p) or, if none has,
+// is split between the first CPU with any room left, which it fills up, and the next one with room for the rest.
+// A job's first portion has a relative deadline equal to its budget, so the split only works for budgets shorter
+// than the thread's deadline. Threads that can't be placed either way go to the least loaded CPU. The caller
+// holds _lock.
+void SPEDF::partition(const Microsecond & c, const Microsecond & p)
+{
+    unsigned long u = (unsigned long long)(c) * UNIT / p;
+
+    for(unsigned int i = 0; i < QUEUES; i++)
+        if(_utilization[i] + u <= UNIT) {
+            _utilization[i] += u;
+            _share = u;
+            _queue = i;
+            return;
+        }
+
+    for(unsigned int i = 0; i < QUEUES - 1; i++) {
+        unsigned long spare = UNIT - _utilization[i];
+        unsigned long budget = Alarm::scheduling_ticks((unsigned long long)(spare) * p / UNIT);
+        if(!budget || (budget >= _deadline))
+            continue;
+        for(unsigned int j = i + 1; j < QUEUES; j++)
+            if(_utilization[j] + u - spare <= UNIT) {
+                _utilization[i] = UNIT;
+                _utilization[j] += u - spare;
+                _share = spare;
+                _split_share = u - spare;
+                _queue = i;
+                _second = j;
+                _budget = budget;
+                return;
+            }
+    }
+
+    unsigned int least = 0;
+    for(unsigned int i = 1; i < QUEUES; i++)
+        if(_utilization[i] < _utilization[least])
+            least = i;
+    _utilization[least] += u;
+    _share = u;
+    _queue = least;
+
+    db<Thread>(WRN) << "SPEDF::partition: utilization exceeded on CPU " << least << "!" << endl;
+}
+
+// Adds "ticks" to the absolute deadline of the current job (or to the one to be restored, if a protocol is applied)
+void SPEDF::shift(int ticks) {
+    volatile int & p = _protocol_applied ? _frozen_priority : _priority;
+    if((p >= PERIODIC) && (p < APERIODIC))
+        p += ticks;
+}
+
+// A new job starts on the first CPU, but a thread still on the second one can only be moved back while it isn't in
+// that CPU's queue (e.g. waiting for the release, see update_on_wait()). Otherwise (i.e. the previous job is still
+// running late) the new job also runs on the second CPU, under its deadline.
+void SPEDF::update() {
+    EDF::update();
+    if(_budget) {
+        _executed = 0;
+        if(_queue == _first)
+            shift(int(_budget) - int(_deadline));
+    }
+}
+
+void SPEDF::update_on_reschedule(const Microsecond & exec_start) {
+    if(!_budget || (_queue != _first))
+        return;
+
+    _executed += Alarm::scheduling_elapsed() - exec_start;
+    if(_executed >= _budget) { // first portion exhausted, the rest of the job runs on the second CPU under its deadline
+        _queue = _second;
+        shift(int(_deadline) - int(_budget));
+    }
+}
+
+// Called right after update() for a thread that is waiting, thus in no scheduling queue, under the lock of the one
+// it was in (see Thread::update_priority()), so the job just released may go back to the first CPU
+void SPEDF::update_on_wait() {
+    if(_budget && (_queue != _first)) {
+        _queue = _first;
+        shift(int(_budget) - int(_deadline));
+    }
 }
 
 // Since the definition of FCFS above is only known to this unit, forcing its instantiation here so it gets emitted in scheduler.o for subsequent linking with other units is necessary.
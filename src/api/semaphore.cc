@@ -4,7 +4,7 @@
 
 __BEGIN_SYS
 
-Semaphore::Semaphore(long v) : Synchronizer_Common(v), _value(v)
+Semaphore::Semaphore(long v) : _value(v)
 {
     db<Synchronizer>(TRC) << "Semaphore(value=" << _value << ") => " << this << endl;
 }
@@ -20,6 +20,9 @@ void Semaphore::p()
 {
     db<Synchronizer>(TRC) << "Semaphore::p(this=" << this << ",value=" << _value << ")" << endl;
 
+    if(_value < 1)
+        spin();
+
     begin_atomic();
     db<Synchronizer>(TRC) << "Semaphore::p lock" << endl;
     if(fdec(_value) < 1){
@@ -47,4 +50,19 @@ void Semaphore::v()
 
 }
 
+
+void Semaphore::v(unsigned int n)
+{
+    db<Synchronizer>(TRC) << "Semaphore::v(this=" << this << ",value=" << _value << ",n=" << n << ")" << endl;
+
+    begin_atomic();
+    for(unsigned int i = 0; i < n; i++)
+        restore_priority();
+    long waiting = -_value;
+    _value += n;
+    if(waiting > 0)
+        wakeup(&_queue, (waiting < long(n)) ? waiting : n);
+    end_atomic();
+}
+
 __END_SYS
@@ -0,0 +1,38 @@
+// EPOS Sequence Lock Implementation
+
+#include <synchronizer.h>
+
+__BEGIN_SYS
+
+Seqlock::Seqlock(): _sequence(0)
+{
+    db<Synchronizer>(TRC) << "Seqlock() => " << this << endl;
+}
+
+
+Seqlock::~Seqlock()
+{
+    db<Synchronizer>(TRC) << "~Seqlock(this=" << this << ")" << endl;
+}
+
+
+void Seqlock::write_lock()
+{
+    db<Synchronizer>(TRC) << "Seqlock::write_lock(this=" << this << ",seq=" << _sequence << ")" << endl;
+
+    _writer.lock();
+    _sequence++;
+    CPU::fence();
+}
+
+
+void Seqlock::write_unlock()
+{
+    db<Synchronizer>(TRC) << "Seqlock::write_unlock(this=" << this << ",seq=" << _sequence << ")" << endl;
+
+    CPU::fence();
+    _sequence++;
+    _writer.unlock();
+}
+
+__END_SYS
@@ -3,6 +3,7 @@
 #include <machine.h>
 #include <system.h>
 #include <process.h>
+#include <synchronizer.h>
 #include <time.h>
 
 extern "C" { volatile unsigned long _running() __attribute__ ((alias ("_ZN4EPOS1S6Thread4selfEv"))); }
@@ -13,7 +14,10 @@ bool Thread::_not_booting;
 volatile unsigned int Thread::_thread_count;
 Scheduler_Timer * Thread::_timer;
 Scheduler<Thread> Thread::_scheduler;
-Spin Thread::_lock;
+Spin Thread::_lock[Criterion::QUEUES];
+volatile unsigned int Thread::_locks[Traits<Machine>::CPUS];
+volatile bool Thread::_deferred_reschedule[Traits<Machine>::CPUS];
+Pool<> Thread::_stack_pool;
 
 
 unsigned long Thread::init_timestamp = 0;
@@ -21,15 +25,18 @@ unsigned long Thread::init_timestamp = 0;
 
 void Thread::constructor_prologue(unsigned int stack_size)
 {
-    lock();
+    lock(queue_lock());
 
     if (profiler && _thread_count == 0)
         init_timestamp = CLINT::mtime();
 
-    _thread_count++;
+    CPU::finc(_thread_count);
     _scheduler.insert(this);
 
-    _stack = new (SYSTEM) char[stack_size];
+    _stack_size = stack_size;
+    _stack = (stack_size == STACK_SIZE) ? reinterpret_cast<char *>(_stack_pool.get()) : 0;
+    if(!_stack)
+        _stack = new (SYSTEM) char[stack_size];
 }
 
 
@@ -48,16 +55,25 @@ void Thread::constructor_epilogue(Log_Addr entry, unsigned int stack_size)
     if((_state != READY) && (_state != RUNNING))
         _scheduler.suspend(this);
 
-    if(preemptive && (_state == READY) && (_link.rank() != IDLE))
-        reschedule_all_cpus();
+    unsigned long cpus = (preemptive && (_state == READY) && (_link.rank() != IDLE)) ? preemptees(this) : 0;
 
-    unlock();
+    unlock(queue_lock());
+
+    reschedule_cpus(cpus);
 }
 
 
 Thread::~Thread()
 {
-    lock();
+    // A thread destroyed while still owning synchronizers must leave their lists of owners
+    while(!_owned.empty()) {
+        Ownership * o = _owned.remove()->object();
+        Synchronizer_Common * s = o->synchronizer;
+        if(s)
+            Synchronizer_Common::disown(s, o);
+    }
+
+    Queue * waiting = lock_state();
 
     db<Thread>(TRC) << "~Thread(this=" << this
                     << ",state=" << _state
@@ -75,29 +91,35 @@ Thread::~Thread()
         break;
     case READY:
         _scheduler.remove(this);
-        _thread_count--;
+        CPU::fdec(_thread_count);
         break;
     case SUSPENDED:
         _scheduler.resume(this);
         _scheduler.remove(this);
-        _thread_count--;
+        CPU::fdec(_thread_count);
         break;
     case WAITING:
-        _waiting->remove(this);
+        waiting->remove(this);
         _scheduler.resume(this);
         _scheduler.remove(this);
-        _thread_count--;
+        CPU::fdec(_thread_count);
         break;
     case FINISHING: // Already called exit()
         break;
     }
 
-    if(_joining)
-        _joining->resume();
+    Thread * joining = _joining;
+    _joining = 0;
 
-    unlock();
+    unlock_state(waiting);
+
+    if(joining)
+        joining->resume();
 
-    delete _stack;
+    criterion().retire();
+
+    if((_stack_size != STACK_SIZE) || !_stack_pool.put(_stack))
+        delete _stack;
 }
 
 Thread * volatile Thread::self() { 
@@ -106,54 +128,188 @@ Thread * volatile Thread::self() {
 
 void Thread::priority(const Criterion & c)
 {
-    lock();
+    Queue * waiting = lock_state();
 
     db<Thread>(TRC) << "Thread::priority(this=" << this << ",prio=" << c << ")" << endl;
 
-    if(_state != RUNNING) { // reorder the scheduling queue
+    // c becomes the thread's base priority, on top of which any priority still inherited is applied
+    int inherited = this->inherited();
+
+    switch(_state) { // reorder the queue the thread is in
+    case READY:
         _scheduler.remove(this);
         _link.rank(c);
+        if(inherited < c)
+            criterion().apply_new_priority(inherited);
         _scheduler.insert(this);
-    } else
+        break;
+    case WAITING:
+        waiting->remove(&_link);
         _link.rank(c);
+        if(inherited < c)
+            criterion().apply_new_priority(inherited);
+        waiting->insert(&_link);
+        break;
+    default:
+        _link.rank(c);
+        if(inherited < c)
+            criterion().apply_new_priority(inherited);
+    }
+
+    unlock_state(waiting);
+
+    // A waiting thread passes its new priority on to the owners of the synchronizer it's waiting on
+    Synchronizer_Common * s = (OWNERSHIPS && waiting) ? waiting->synchronizer() : 0;
+    if(s) {
+        lock(waiting->lock());
+        Synchronizer_Common::propagate(s, s->get_new_priority(this));
+        unlock(waiting->lock());
+    }
 
     if(preemptive)
-        reschedule();
+        reschedule(CPU::id());
+}
 
-    unlock();
+// Restricts the thread to the CPUs in "mask" (see Migrating_Scheduler). A ready thread is pushed to one of them if it
+// preempts what runs there, while a thread running elsewhere has its CPU rescheduled, which pushes it on.
+void Thread::affinity(unsigned long mask)
+{
+    Queue * waiting = lock_state();
+
+    db<Thread>(TRC) << "Thread::affinity(this=" << this << ",mask=" << hex << mask << dec << ")" << endl;
+
+    criterion().affinity(mask);
+
+    unsigned long cpus = 0;
+    if(preemptive && (_state == READY))
+        cpus = preemptees(this);
+    else if(preemptive && (_state == RUNNING)) {
+        for(unsigned int cpu = 0; cpu < Traits<Machine>::CPUS; cpu++)
+            if((_scheduler.chosen_at(cpu) == this) && !criterion().eligible(cpu))
+                cpus |= 1UL << cpu;
+    }
+
+    unlock_state(waiting);
+
+    reschedule_cpus(cpus);
+}
+
+// Makes the thread inherit "new_priority" through the synchronizer it owns as recorded in "o", requeuing it wherever
+// it is if that raises its priority. Returns the Queue the thread waits on when its priority got raised while waiting,
+// so the caller can pass the boost on to the owners of that synchronizer.
+Thread::Queue * Thread::apply_new_priority(Ownership * o, int new_priority)
+{
+    Queue * waiting = lock_state();
+
+    if(new_priority < o->inherited)
+        o->inherited = new_priority;
+
+    bool raised = (new_priority < _link.rank());
+    unsigned long cpus = 0;
+
+    if(raised) {
+        switch(_state) {
+        case READY:
+            _scheduler.remove(this);
+            criterion().apply_new_priority(new_priority);
+            _scheduler.insert(this);
+            cpus = preemptive ? preemptees(this) : 0;
+            break;
+        case WAITING:
+            waiting->remove(&_link);
+            criterion().apply_new_priority(new_priority);
+            waiting->insert(&_link);
+            break;
+        case FINISHING:
+            break;
+        default: // RUNNING, maybe on another CPU, or SUSPENDED
+            criterion().apply_new_priority(new_priority);
+        }
+    }
+
+    unlock_state(waiting);
+
+    reschedule_cpus(cpus);
+
+    return raised ? waiting : 0;
 }
 
-void Thread::apply_new_priority(int new_priority)
+// Recomputes the running thread's priority after it released a synchronizer: the highest one it still inherits
+// through the synchronizers it owns, or its own if that's higher
+void Thread::restore_priority()
+{
+    Queue * waiting = lock_state();
+
+    int before = _link.rank();
+    int inherited = this->inherited();
+    if(inherited < criterion().base_priority())
+        criterion().apply_new_priority(inherited);
+    else if(criterion().protocol_applied())
+        criterion().restore_priority();
+    bool lowered = (_link.rank() > before);
+
+    unlock_state(waiting);
+
+    if(preemptive && lowered)
+        reschedule(CPU::id());
+}
+
+// Called at each job release of a periodic thread under a dynamic criterion (e.g. EDF's new absolute deadline). Just
+// like with priority(), the queue the thread is in is reordered, since wakeup_all() merges waiting queues into the
+// ready one assuming both are still ordered by the current ranks. A waiting thread is in no scheduling queue, so a
+// partitioned criterion may also move it to another one (see SPEDF), thus the lock taken is the one released.
+void Thread::update_priority()
 {
+    Queue * waiting = lock_state();
+    Spin * lock = queue_lock();
+
+    db<Thread>(TRC) << "Thread::update_priority(this=" << this << ",prio=" << _link.rank() << ")" << endl;
+
     switch(_state) {
-    case RUNNING:
-        break;
     case READY:
         _scheduler.remove(this);
-        criterion().apply_new_priority(new_priority);
+        criterion().update();
         _scheduler.insert(this);
         break;
-    case SUSPENDED:
-        criterion().apply_new_priority(new_priority);
-        break;
     case WAITING:
-        _waiting->remove(&_link);
-        criterion().apply_new_priority(new_priority);
-        _waiting->insert(&_link);
-        break;
-    case FINISHING:
+        waiting->remove(&_link);
+        criterion().update();
+        criterion().update_on_wait();
+        waiting->insert(&_link);
         break;
+    default:
+        criterion().update();
     }
+
+    if(waiting) {
+        release(lock);
+        unlock(waiting->lock());
+    } else
+        unlock(lock);
 }
 
-void Thread::restore_priority()
+// The highest priority inherited through the synchronizers the thread owns (IDLE if none). Ownership records are
+// only added and removed by the thread itself, and their priorities only change under lock_state().
+int Thread::inherited()
 {
-    criterion().restore_priority();
+    int inherited = IDLE;
+    for(Ownerships::Iterator i = _owned.begin(); i != _owned.end(); i++) {
+        Ownership * o = i->object();
+        if(o->synchronizer && (o->inherited < inherited))
+            inherited = o->inherited;
+    }
+    return inherited;
 }
 
 int Thread::join()
 {
-    lock();
+    // Both the joiner's and the joined thread's scheduling queues are locked (in address order) to set _joining
+    Spin * mine = &_lock[Criterion::current_queue()];
+    Spin * its = queue_lock();
+    lock((its < mine) ? its : mine);
+    if(its != mine)
+        acquire((its < mine) ? mine : its);
+
     db<Thread>(TRC) << "Thread::join(this=" << this << ",state=" << _state << ")" << endl;
 
     // Precondition: no Thread::self()->join()
@@ -171,8 +327,12 @@ int Thread::join()
 
         Thread * next = _scheduler.chosen();
 
+        if(its != mine)
+            release(its);
+
         dispatch(prev, next);
-    }
+    } else if(its != mine)
+        release(its);
 
     unlock();
 
@@ -199,7 +359,7 @@ void Thread::pass()
 
 void Thread::suspend()
 {
-    lock();
+    lock(queue_lock());
     db<Thread>(TRC) << "Thread::suspend(this=" << this << ")" << endl;
 
     Thread * prev = running();
@@ -211,25 +371,28 @@ void Thread::suspend()
 
     dispatch(prev, next);
 
-    unlock();
+    unlock(queue_lock());
 }
 
 
 void Thread::resume()
 {
-    lock();
+    lock(queue_lock());
     db<Thread>(TRC) << "Thread::resume(this=" << this << ")" << endl;
 
+    unsigned long cpus = 0;
     if(_state == SUSPENDED) {
         _state = READY;
         _scheduler.resume(this);
 
         if(preemptive)
-            reschedule_all_cpus();
+            cpus = preemptees(this);
     } else
         db<Thread>(WRN) << "Resume called for unsuspended object!" << endl;
 
-    unlock();
+    unlock(queue_lock());
+
+    reschedule_cpus(cpus);
 }
 
 
@@ -249,16 +412,28 @@ void Thread::yield()
 
 void Thread::exit(int status)
 {
-    lock();
+    Spin * mine = &_lock[Criterion::current_queue()];
+    lock(mine);
 
     db<Thread>(TRC) << "Thread::exit(status=" << status << ") [running=" << running() << "]" << endl;
 
     Thread * prev = running();
+
+    // The joiner's scheduling queue must also be locked to resume it. _joining cannot change meanwhile,
+    // since join() sets it holding our lock and there is a single joiner.
+    Spin * its = prev->_joining ? prev->_joining->queue_lock() : mine;
+    if(its < mine) {
+        release(mine);
+        acquire(its);
+        acquire(mine);
+    } else if(its != mine)
+        acquire(its);
+
     _scheduler.remove(prev);
     prev->_state = FINISHING;
     *reinterpret_cast<int *>(prev->_stack) = status;
 
-    _thread_count--;
+    CPU::fdec(_thread_count);
 
     if(prev->_joining) {
         prev->_joining->_state = READY;
@@ -266,6 +441,9 @@ void Thread::exit(int status)
         prev->_joining = 0;
     }
 
+    if(its != mine)
+        release(its);
+
     Thread * next = _scheduler.choose(); // at least idle will always be there
 
     dispatch(prev, next);
@@ -274,13 +452,58 @@ void Thread::exit(int status)
 }
 
 
+Thread::Queue * Thread::lock_state()
+{
+    CPU::int_disable();
+
+    for(;;) {
+        // A partitioned criterion may move the thread to another queue meanwhile (see reschedule() and update_priority())
+        Spin * lock = queue_lock();
+        acquire(lock);
+        if(lock != queue_lock()) {
+            release(lock);
+            continue;
+        }
+
+        Queue * waiting = (_state == WAITING) ? _waiting : 0;
+        if(!waiting)
+            return 0;
+
+        // The waiting queue's lock precedes the scheduling queue's, so retry in order
+        release(lock);
+        acquire(waiting->lock());
+        lock = queue_lock();
+        acquire(lock);
+
+        if((_state == WAITING) && (_waiting == waiting) && (lock == queue_lock()))
+            return waiting;
+
+        release(lock);
+        release(waiting->lock());
+    }
+}
+
+
+void Thread::unlock_state(Queue * waiting)
+{
+    if(waiting) {
+        release(queue_lock());
+        unlock(waiting->lock());
+    } else
+        unlock(queue_lock());
+}
+
+
 void Thread::sleep(Queue * q)
 {
     db<Thread>(TRC) << "Thread::sleep(running=" << running() << ",q=" << q << ")" << endl;
 
-    assert(locked()); // locking handled by caller
+    assert(locked()); // the caller holds q->lock()
 
     Thread * prev = running();
+
+    acquire(&_lock[Criterion::current_queue()]);
+
     _scheduler.suspend(prev);
     prev->_state = WAITING;
     prev->_waiting = q;
@@ -288,7 +511,13 @@ void Thread::sleep(Queue * q)
 
     Thread * next = _scheduler.chosen();
 
+    // Never block holding the waiting queue's lock; it is given back to the caller once we are woken up
+    release(q->lock());
+
     dispatch(prev, next);
+
+    release(&_lock[Criterion::current_queue()]);
+    acquire(q->lock());
 }
 
 
@@ -296,16 +525,19 @@ void Thread::wakeup(Queue * q)
 {
     db<Thread>(TRC) << "Thread::wakeup(running=" << running() << ",q=" << q << ")" << endl;
 
-    assert(locked()); // locking handled by caller
+    assert(locked()); // the caller holds q->lock()
 
     if(!q->empty()) {
         Thread * t = q->remove()->object();
+
+        acquire(t->queue_lock());
         t->_state = READY;
         t->_waiting = 0;
         _scheduler.resume(t);
+        unsigned long cpus = preemptive ? preemptees(t) : 0;
+        release(t->queue_lock());
 
-        if(preemptive)
-            reschedule_all_cpus();
+        reschedule_cpus(cpus);
     }
 }
 
@@ -314,19 +546,94 @@ void Thread::wakeup_all(Queue * q)
 {
     db<Thread>(TRC) << "Thread::wakeup_all(running=" << running() << ",q=" << q << ")" << endl;
 
-    assert(locked()); // locking handled by caller
-
-    if(!q->empty()) {
+    assert(locked()); // the caller holds q->lock()
+
+    if(q->empty())
+        return;
+
+    unsigned long cpus = 0;
+    if(Criterion::QUEUES == 1) {
+        // All waiters go to the same scheduling queue and the waiting queue is ordered just like it (ranks only change
+        // with the thread out of the queue it is in, see priority() and update_priority()), so they are merged into it
+        // in a single pass. Waiters come in priority order, so once one of them can't preempt any
+        // CPU, neither can the following ones.
+        acquire(&_lock[0]);
+        bool preempting = preemptive;
+        for(Queue::Element * e = q->head(); e; e = e->next()) {
+            Thread * t = e->object();
+            t->_state = READY;
+            t->_waiting = 0;
+            if(preempting) {
+                unsigned long more = preemptees(t, cpus);
+                preempting = (more != cpus);
+                cpus = more;
+            }
+        }
+        _scheduler.resume_all(q);
+        release(&_lock[0]);
+    } else {
         while(!q->empty()) {
             Thread * t = q->remove()->object();
+
+            acquire(t->queue_lock());
             t->_state = READY;
             t->_waiting = 0;
             _scheduler.resume(t);
+            if(preemptive)
+                cpus = preemptees(t, cpus);
+            release(t->queue_lock());
         }
+    }
+
+    reschedule_cpus(cpus);
+}
+
 
+void Thread::wakeup(Queue * q, unsigned int n)
+{
+    db<Thread>(TRC) << "Thread::wakeup(running=" << running() << ",q=" << q << ",n=" << n << ")" << endl;
+
+    assert(locked()); // the caller holds q->lock()
+
+    if(n >= q->size()) {
+        wakeup_all(q);
+        return;
+    }
+
+    unsigned long cpus = 0;
+    for(; n; n--) {
+        Thread * t = q->remove()->object();
+
+        acquire(t->queue_lock());
+        t->_state = READY;
+        t->_waiting = 0;
+        _scheduler.resume(t);
         if(preemptive)
-            reschedule_all_cpus();
+            cpus = preemptees(t, cpus);
+        release(t->queue_lock());
     }
+
+    reschedule_cpus(cpus);
+}
+
+Thread * Thread::requeue(Queue * from, Queue * to)
+{
+    db<Thread>(TRC) << "Thread::requeue(running=" << running() << ",from=" << from << ",to=" << to << ")" << endl;
+
+    assert(locked()); // the caller holds both from->lock() and to->lock()
+
+    if(from->empty())
+        return 0;
+
+    // The thread keeps WAITING, just somewhere else
+    Thread * t = from->remove()->object();
+
+    acquire(t->queue_lock());
+    t->_waiting = to;
+    to->insert(&t->_link);
+    release(t->queue_lock());
+
+    return t;
 }
 
 void Thread::reschedule(unsigned int cpu_id)
@@ -334,10 +641,14 @@ void Thread::reschedule(unsigned int cpu_id)
     if(!Criterion::timed || Traits<Thread>::hysterically_debugged)
         db<Thread>(TRC) << "Thread::reschedule(int cpu_id)" << endl;
 
-    assert(locked()); // locking handled by caller
-
     if (!multicore || (cpu_id == CPU::id())) {
-        reschedule();
+        if(locked()) // only the current scheduling queue's lock may be held when dispatching
+            _deferred_reschedule[CPU::id()] = true;
+        else {
+            lock();
+            reschedule();
+            unlock();
+        }
     } else {
         db<Thread>(TRC) << "INT_RESCHEDULER sent from" << CPU::id() << " to " << cpu_id << endl;
         IC::ipi(cpu_id, IC::INT_RESCHEDULER);
@@ -353,8 +664,28 @@ void Thread::reschedule()
 
     Thread * prev = running();
     prev->criterion().update_on_reschedule(prev->_exec_start);
+
+    // A partitioned criterion may have just moved the running thread to another CPU's queue (e.g. a split SPEDF
+    // job that exhausted its first portion), in which case choose() hands it over to that queue under its lock
+    // (always a higher numbered one, so the two locks are taken in address order)
+    unsigned int queue = prev->criterion().queue();
+    bool handover = (Criterion::QUEUES > 1) && (queue != Criterion::current_queue());
+    if(handover)
+        acquire(&_lock[queue]);
+
     Thread * next = _scheduler.choose();
-    next->_exec_start = Alarm::elapsed();
+    next->_exec_start = Alarm::scheduling_elapsed();
+
+    if(handover) {
+        unsigned long cpus = preemptees(prev);
+        release(&_lock[queue]);
+        reschedule_cpus(cpus);
+    }
+
+    // A thread displaced from this CPU (e.g. by one that may only run here) may still preempt another one
+    if(Criterion::migrating && (prev != next) && (prev->_state == RUNNING) && (prev->priority() != IDLE))
+        reschedule_cpus(preemptees(prev, 1UL << CPU::id()));
+
     dispatch(prev, next);
 }
 
@@ -363,13 +694,52 @@ void Thread::reschedule_all_cpus()
     if(!Criterion::timed || Traits<Thread>::hysterically_debugged)
         db<Thread>(TRC) << "Thread::reschedule_all_cpus()" << endl;
 
-    assert(locked()); // locking handled by caller
+    reschedule_cpus(~0UL);
+}
 
+void Thread::reschedule_cpus(unsigned long cpus)
+{
     for(unsigned int i = 0; i < Traits<Machine>::CPUS; i++) {
-        if (i != CPU::id())
+        if((i != CPU::id()) && (cpus & (1UL << i)))
             reschedule(i);
     }
-    reschedule();
+    if(cpus & (1UL << CPU::id()))
+        reschedule(CPU::id());
+}
+
+// Adds to "cpus" the CPU, if any, that must reschedule for "t" (just made READY) to run. With partitioned
+// criteria that is the CPU owning t's queue, otherwise the one, not yet in "cpus", running the lowest
+// priority (or latest deadline) thread among those "t" may run on (see Criterion::eligible()), preferring
+// the current CPU on ties. Either way, it is only interrupted if "t" would preempt what it is running. The caller holds t's scheduling queue lock,
+// which also guards the threads chosen by the CPUs that share it.
+unsigned long Thread::preemptees(Thread * t, unsigned long cpus)
+{
+    unsigned int target = CPU::id();
+
+    if(Criterion::QUEUES > 1)
+        target = t->criterion().queue();
+    else {
+        Thread * lowest = 0;
+        for(unsigned int i = 0, cpu = CPU::id(); i < Traits<Machine>::CPUS; i++, cpu = (cpu + 1) % Traits<Machine>::CPUS) {
+            if((cpus & (1UL << cpu)) || !t->criterion().eligible(cpu))
+                continue;
+            Thread * chosen = _scheduler.chosen_at(cpu);
+            if(!lowest || !chosen || (chosen->priority() > lowest->priority())) {
+                lowest = chosen;
+                target = cpu;
+                if(!chosen)
+                    break;
+            }
+        }
+        if((cpus & (1UL << target)) || !t->criterion().eligible(target))
+            return cpus;
+    }
+
+    Thread * chosen = _scheduler.chosen_at(target);
+    if(!chosen || (t->priority() < chosen->priority()))
+        cpus |= (1UL << target);
+
+    return cpus;
 }
 
 void Thread::rescheduler(IC::Interrupt_Id i)
@@ -395,14 +765,23 @@ void Thread::dispatch(Thread * prev, Thread * next, bool charge)
     // "next" is not in the scheduler's queue anymore. It's already "chosen"
 
     if(charge) {
-        if(Criterion::timed)
-            _timer->restart();
+        if(Criterion::timed) {
+            if(Timer::tickless && (next->priority() == IDLE))
+                _timer->stop(); // idle CPUs sleep until an IPI or an alarm wakes them up
+            else if(Timer::tickless && Criterion::laxity)
+                _timer->restart(laxity_crossing(next));
+            else
+                _timer->restart();
+        }
     }
 
     if(prev != next) {
         if(prev->_state == RUNNING)
             prev->_state = READY;
         next->_state = RUNNING;
+        next->_exec_start = Alarm::scheduling_elapsed(); // also when not dispatched by reschedule()
+        if(Criterion::migrating)
+            next->criterion().dispatched(CPU::id());
 
         db<Thread>(TRC) << "Thread::dispatch(prev=" << prev << ",next=" << next << ")" << endl;
         if(Traits<Thread>::debugged && Traits<Debug>::info) {
@@ -412,9 +791,9 @@ void Thread::dispatch(Thread * prev, Thread * next, bool charge)
         }
         db<Thread>(INF) << "Thread::dispatch:next={" << next << ",ctx=" << *next->_context << "}" << endl;
 
-        // assert(_lock.level() == 1);
+        // Only the current scheduling queue's lock is held at this point (see Thread::lock())
         db<Thread>(TRC) << "locked released at dispatch" << endl;
-        _lock.release();
+        release(&_lock[Criterion::current_queue()]);
 
         // The non-volatile pointer to volatile pointer to a non-volatile context is correct
         // and necessary because of context switches, but here, we are locked() and
@@ -424,13 +803,32 @@ void Thread::dispatch(Thread * prev, Thread * next, bool charge)
         CPU::switch_context(const_cast<Context **>(&prev->_context), next->_context);
 
         CPU::int_disable();
-        _lock.acquire();
+        acquire(&_lock[Criterion::current_queue()]);
         db<Thread>(TRC) << "locked acquired at dispatch" << endl;
 
     }
 }
 
 
+// The time, bounded by the quantum, until "next"'s priority, which decays while it runs, falls behind that of the
+// first thread ready to run on the same queue. In tickless mode, that is when the scheduler timer must preempt it.
+Microsecond Thread::laxity_crossing(Thread * next)
+{
+    Thread * ready = _scheduler.head() ? _scheduler.head()->object() : 0;
+
+    if(!ready || (ready->priority() < Criterion::PERIODIC) || (ready->priority() >= Criterion::APERIODIC)
+       || (next->priority() < Criterion::PERIODIC) || (next->priority() >= Criterion::APERIODIC))
+        return QUANTUM;
+
+    int ticks = (ready->priority() > next->priority()) ? ready->priority() - next->priority() + 1 : 1;
+    Microsecond time = ticks * Alarm::scheduling_period();
+    if(time > QUANTUM)
+        time = QUANTUM;
+
+    return time;
+}
+
+
 int Thread::idle()
 {
     db<Thread>(TRC) << "Thread::idle(this=" << running() << ")" << endl;
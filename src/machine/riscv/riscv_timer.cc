@@ -6,13 +6,37 @@
 __BEGIN_SYS
 
 Timer * Timer::_channels[CHANNELS];
+Simple_Spin Timer::_lock[Traits<Machine>::CPUS];
 
 void Timer::int_handler(Interrupt_Id i)
 {
     // db<Thread>(WRN) << "TIME INTERRUPTION!." << endl;
 
-    if((CPU::id() == 0) && _channels[ALARM] && (--_channels[ALARM]->_current[0] <= 0)) {
-        _channels[ALARM]->_current[0] = _channels[ALARM]->_initial;
+    if(tickless) {
+        unsigned int cpu = CPU::id();
+        Time_Stamp now = mtime();
+        bool due[CHANNELS];
+
+        // Rearm (or disarm) the expired channels and reprogram the CLINT before calling any handler, since handlers may dispatch
+        _lock[cpu].acquire();
+        for(unsigned int c = 0; c < CHANNELS; c++) {
+            due[c] = _channels[c] && (_channels[c]->_deadline[cpu] <= now);
+            if(due[c])
+                _channels[c]->_deadline[cpu] = _channels[c]->_retrigger ? now + _channels[c]->_period : DISARMED;
+        }
+        update(cpu);
+        _lock[cpu].release();
+
+        if(due[ALARM] && _channels[ALARM])
+            _channels[ALARM]->_handler(i);
+        if(due[SCHEDULER] && _channels[SCHEDULER])
+            _channels[SCHEDULER]->_handler(i);
+
+        return;
+    }
+
+    if(_channels[ALARM] && ((CPU::id() == 0) || _channels[ALARM]->_per_cpu) && (--_channels[ALARM]->_current[CPU::id()] <= 0)) {
+        _channels[ALARM]->_current[CPU::id()] = _channels[ALARM]->_initial;
         _channels[ALARM]->_handler(i);
     }
 
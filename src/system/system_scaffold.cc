@@ -30,6 +30,7 @@ extern "C" {
 
     static volatile int _print_lock = -1;
     static Spin _heap_lock;
+    static Spin _heap_cache_lock[Traits<Build>::CPUS];
 
     // Libc legacy
     void _panic() { Machine::panic(); }
@@ -72,4 +73,14 @@ extern "C" {
 
     void _lock_heap() { Thread::lock(&_heap_lock); }
     void _unlock_heap() { Thread::unlock(&_heap_lock); }
+
+    // A per-CPU heap cache is only ever touched by its CPU, but the running thread must not be preempted (and maybe
+    // migrated) while using it, so the CPU is taken only after interrupts get disabled
+    unsigned int _lock_heap_cache() {
+        CPU::int_disable();
+        unsigned int cpu = CPU::id();
+        Thread::lock(&_heap_cache_lock[cpu]);
+        return cpu;
+    }
+    void _unlock_heap_cache(unsigned int cpu) { Thread::unlock(&_heap_cache_lock[cpu]); }
 }
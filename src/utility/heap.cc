@@ -13,4 +13,11 @@ void Simple_Heap::out_of_memory(unsigned long bytes)
     _panic();
 }
 
+void TLSF_Heap::out_of_memory(unsigned long bytes)
+{
+    db<Heaps, System>(ERR) << "Heap::alloc(this=" << this << "): out of memory while allocating " << bytes << " bytes!" << endl;
+
+    _panic();
+}
+
 __END_UTIL
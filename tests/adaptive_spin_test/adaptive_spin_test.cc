@@ -0,0 +1,130 @@
+// EPOS Adaptive Spinning Mutex and Semaphore Test Program
+
+#include <synchronizer.h>
+#include <process.h>
+
+using namespace EPOS;
+
+const unsigned int THREADS = 8;
+const unsigned int ITERATIONS = 5000;
+const unsigned int LONG_EVERY = 64;     // every so many iterations, a critical section outlasts the waiters' spinning
+const unsigned int LONG_WORK = 20000;   // busy loop iterations in such a critical section (well above adaptive_spin)
+const unsigned int ROUNDS = 5000;       // ping-pong hand-offs
+
+OStream cout;
+
+Mutex mutex;
+Semaphore semaphore;                    // binary, as a lock
+Semaphore ping(0);
+Semaphore pong(0);
+
+volatile unsigned int inside;           // threads inside the critical section (must never be more than one)
+volatile unsigned int overlaps;
+unsigned long counter;                  // incremented without atomics, so any overlap loses updates
+volatile unsigned long ball;            // ping-pong rounds, each written only by the thread holding the ball
+
+void increment(unsigned int i) {
+    if(CPU::finc(inside) != 0)
+        CPU::finc(overlaps);
+    unsigned long c = counter;
+    // Most critical sections are short enough for a spinning waiter to get in, some make it give up and sleep
+    for(volatile unsigned int j = 0; j < ((i % LONG_EVERY) ? 8 : LONG_WORK); j++);
+    counter = c + 1;
+    CPU::fdec(inside);
+}
+
+int with_mutex(unsigned int n)
+{
+    for(unsigned int i = 0; i < ITERATIONS; i++) {
+        mutex.lock();
+        increment(i + n);
+        mutex.unlock();
+    }
+    return n;
+}
+
+int with_semaphore(unsigned int n)
+{
+    for(unsigned int i = 0; i < ITERATIONS; i++) {
+        semaphore.p();
+        increment(i + n);
+        semaphore.v();
+    }
+    return n;
+}
+
+// Each v() is soon followed by a p() on the other CPU, so a spinning p() usually finds the value it waits for
+int pinger(unsigned int n)
+{
+    for(unsigned int i = 0; i < ROUNDS; i++) {
+        ball = ball + 1;
+        pong.v();
+        ping.p();
+    }
+    return n;
+}
+
+int ponger(unsigned int n)
+{
+    for(unsigned int i = 0; i < ROUNDS; i++) {
+        pong.p();
+        ball = ball + 1;
+        ping.v();
+    }
+    return n;
+}
+
+unsigned int run(const char * name, int (* entry)(unsigned int))
+{
+    counter = 0;
+    overlaps = 0;
+
+    Thread * thread[THREADS];
+    for(unsigned int i = 0; i < THREADS; i++)
+        thread[i] = new Thread(entry, i);
+    for(unsigned int i = 0; i < THREADS; i++) {
+        thread[i]->join();
+        delete thread[i];
+    }
+
+    unsigned int failures = overlaps + (counter != THREADS * ITERATIONS);
+    cout << name << ": counter = " << counter << " (expected " << THREADS * ITERATIONS << "), overlaps = " << overlaps
+         << " => " << (failures ? "FAILED" : "passed") << endl;
+
+    return failures;
+}
+
+int main()
+{
+    cout << "Adaptive Spinning Mutex and Semaphore Test" << endl;
+
+    cout << "\nThis test runs " << THREADS << " threads on " << Traits<Machine>::CPUS << " CPUs with Traits<Synchronizer>::adaptive_spin = "
+         << Traits<Synchronizer>::adaptive_spin << ", so a thread that" << endl;
+    cout << "finds a Mutex or Semaphore taken polls it for a while before blocking. The threads increment a shared" << endl;
+    cout << "counter " << ITERATIONS << " times each inside a critical section guarded first by a Mutex and then by a binary Semaphore." << endl;
+    cout << "Every " << LONG_EVERY << "th critical section is long enough for the waiters to give up spinning and sleep. The counter" << endl;
+    cout << "must account for every increment and no two threads may ever be inside at once. Finally, two threads" << endl;
+    cout << "pass a ball back and forth " << ROUNDS << " times through two Semaphores, and no hand-off may be lost." << endl << endl;
+
+    unsigned int failures = 0;
+    failures += run("Mutex", &with_mutex);
+    failures += run("Semaphore", &with_semaphore);
+
+    Thread * a = new Thread(&pinger, 0U);
+    Thread * b = new Thread(&ponger, 1U);
+    a->join();
+    b->join();
+    delete a;
+    delete b;
+
+    bool lost = (ball != 2 * ROUNDS);
+    cout << "Ping-pong: " << ball << " hand-offs (expected " << 2 * ROUNDS << ") => " << (lost ? "FAILED" : "passed") << endl;
+    failures += lost;
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+// EPOS Barrier Test Program
+
+#include <time.h>
+#include <synchronizer.h>
+#include <process.h>
+
+using namespace EPOS;
+
+const unsigned int MAX_THREADS = 8;
+const unsigned int ROUNDS = 100;
+const unsigned int POLLS = 1000;        // polls a waiter makes before sleeping, in the runs that poll
+
+OStream cout;
+
+Barrier * barrier;
+unsigned int participants;
+volatile unsigned int arrived[ROUNDS];  // threads that got to each round
+volatile unsigned int serial[ROUNDS];   // threads for which wait() returned true in each round
+volatile unsigned int failures;
+
+int worker(unsigned int n)
+{
+    unsigned int seed = n + 1;
+    for(unsigned int r = 0; r < ROUNDS; r++) {
+        // Threads get to the barrier at different times, so some poll and some sleep
+        seed = seed * 1103515245 + 12345;
+        unsigned int work = (seed >> 16) % 4;
+        if(work == 1)
+            Thread::yield();
+        else if(work == 2)
+            Alarm::delay(200);
+
+        CPU::finc(arrived[r]);
+        if(barrier->wait())
+            CPU::finc(serial[r]);
+
+        // Nobody may leave a round before everybody got to it
+        if(arrived[r] != participants)
+            CPU::finc(failures);
+    }
+    return n;
+}
+
+unsigned int run(unsigned int n, unsigned int spin)
+{
+    participants = n;
+    failures = 0;
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        arrived[r] = serial[r] = 0;
+
+    barrier = new Barrier(n, spin);
+
+    Thread * thread[MAX_THREADS];
+    for(unsigned int i = 0; i < n; i++)
+        thread[i] = new Thread(&worker, i);
+    for(unsigned int i = 0; i < n; i++) {
+        thread[i]->join();
+        delete thread[i];
+    }
+
+    delete barrier;
+
+    // Exactly one thread per round must have released the others
+    for(unsigned int r = 0; r < ROUNDS; r++)
+        if(serial[r] != 1)
+            failures++;
+
+    cout << n << " participants" << (spin ? "" : " (never polling)") << ": " << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+
+    return failures;
+}
+
+int main()
+{
+    cout << "Barrier Test" << endl;
+
+    cout << "\nThis test has groups of threads on " << Traits<Machine>::CPUS << " CPUs go through a Barrier " << ROUNDS << " times. Group sizes" << endl;
+    cout << "don't divide evenly among the CPUs (or are smaller than their number), so some CPUs' counters expect" << endl;
+    cout << "more threads than others and threads often count themselves in other CPUs' counters. No thread may" << endl;
+    cout << "leave a round before all got to it and exactly one per round must be told it released the others." << endl << endl;
+
+    unsigned int total = 0;
+    total += run(7, POLLS);
+    total += run(5, 0);
+    total += run(3, POLLS);
+    total += run(6, 0);
+    total += run(MAX_THREADS, POLLS);
+
+    cout << "\n" << (total ? "FAILED" : "passed") << " (" << total << " failures)" << endl;
+    assert(!total);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+// EPOS Condition Variable (with Mutex) Test Program
+
+#include <time.h>
+#include <synchronizer.h>
+#include <process.h>
+
+using namespace EPOS;
+
+const unsigned int PRODUCERS = 3;
+const unsigned int CONSUMERS = 3;
+const unsigned int ITEMS = 500;         // per producer
+const unsigned int BUF_SIZE = 4;
+const unsigned int WAITERS = 6;
+
+OStream cout;
+
+Mutex mutex;
+Condition not_full;
+Condition not_empty;
+Condition go;
+
+unsigned int buffer[BUF_SIZE];
+unsigned int count, in, out;            // all guarded by mutex
+bool consumed[PRODUCERS * ITEMS];
+bool started;
+unsigned int released;
+
+volatile unsigned int holders;          // threads that believe they hold the mutex (must never be more than one)
+volatile unsigned int failures;
+
+void enter() {
+    if(CPU::finc(holders) != 0)
+        CPU::finc(failures);
+}
+
+void leave() {
+    CPU::fdec(holders);
+}
+
+int producer(unsigned int n)
+{
+    for(unsigned int i = 0; i < ITEMS; i++) {
+        mutex.lock();
+        enter();
+        while(count == BUF_SIZE) {
+            leave();
+            not_full.wait(mutex);
+            enter();
+        }
+        buffer[in] = n * ITEMS + i;
+        in = (in + 1) % BUF_SIZE;
+        count++;
+
+        // Signal both while holding the mutex (so the consumer is moved onto the mutex's queue) and after releasing it
+        if(i % 2) {
+            not_empty.signal();
+            leave();
+            mutex.unlock();
+        } else {
+            leave();
+            mutex.unlock();
+            not_empty.signal();
+        }
+    }
+    return n;
+}
+
+int consumer(unsigned int n)
+{
+    for(unsigned int i = 0; i < PRODUCERS * ITEMS / CONSUMERS; i++) {
+        mutex.lock();
+        enter();
+        while(count == 0) {
+            leave();
+            not_empty.wait(mutex);
+            enter();
+        }
+        unsigned int item = buffer[out];
+        out = (out + 1) % BUF_SIZE;
+        count--;
+        if(consumed[item])
+            CPU::finc(failures);
+        consumed[item] = true;
+        not_full.signal();
+        leave();
+        mutex.unlock();
+    }
+    return n;
+}
+
+int waiter(unsigned int n)
+{
+    mutex.lock();
+    enter();
+    while(!started) {
+        leave();
+        go.wait(mutex);
+        enter();
+    }
+    released++;
+    leave();
+    mutex.unlock();
+    return n;
+}
+
+int main()
+{
+    cout << "Condition Variable Test" << endl;
+
+    cout << "\nThis test first runs " << PRODUCERS << " producers and " << CONSUMERS << " consumers on " << Traits<Machine>::CPUS << " CPUs over a buffer of "
+         << BUF_SIZE << " items guarded by" << endl;
+    cout << "a Mutex and two Conditions, signaled both with and without the mutex held. Every item must be consumed" << endl;
+    cout << "exactly once. Then " << WAITERS << " threads wait on a Condition until main broadcasts it with the mutex held. All of" << endl;
+    cout << "them must wake up. Throughout, a thread returning from wait() must hold the mutex alone." << endl;
+
+    Thread * thread[PRODUCERS + CONSUMERS];
+    for(unsigned int i = 0; i < PRODUCERS; i++)
+        thread[i] = new Thread(&producer, i);
+    for(unsigned int i = 0; i < CONSUMERS; i++)
+        thread[PRODUCERS + i] = new Thread(&consumer, i);
+    for(unsigned int i = 0; i < PRODUCERS + CONSUMERS; i++) {
+        thread[i]->join();
+        delete thread[i];
+    }
+
+    unsigned int missing = 0;
+    for(unsigned int i = 0; i < PRODUCERS * ITEMS; i++)
+        if(!consumed[i])
+            missing++;
+    cout << "\nItems consumed: " << PRODUCERS * ITEMS - missing << " of " << PRODUCERS * ITEMS << endl;
+
+    Thread * waiters[WAITERS];
+    for(unsigned int i = 0; i < WAITERS; i++)
+        waiters[i] = new Thread(&waiter, i);
+
+    Alarm::delay(100000); // let them all wait
+
+    mutex.lock();
+    enter();
+    started = true;
+    go.broadcast();
+    leave();
+    mutex.unlock();
+
+    for(unsigned int i = 0; i < WAITERS; i++) {
+        waiters[i]->join();
+        delete waiters[i];
+    }
+    cout << "Waiters released by the broadcast: " << released << " of " << WAITERS << endl;
+
+    unsigned int total = failures + missing + (released != WAITERS);
+    cout << "\n" << (total ? "FAILED" : "passed") << " (" << total << " failures)" << endl;
+    assert(!total);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
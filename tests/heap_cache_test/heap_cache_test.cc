@@ -0,0 +1,119 @@
+// EPOS Per-CPU Heap Caches Test Program
+
+#include <process.h>
+
+using namespace EPOS;
+
+const unsigned int THREADS = 8;         // twice the CPUs, so threads get preempted and migrate in the middle of allocations
+const unsigned int BLOCKS = 32;
+const unsigned int ROUNDS = 64;
+const unsigned int MAX_SIZE = 3000;     // bytes, so both cached (up to 2 KB) and uncached blocks are used
+
+OStream cout;
+
+// Each block starts with its size and a seed, followed by a pattern derived from them
+struct Header {
+    unsigned int size;
+    unsigned int seed;
+};
+
+char * volatile exchange[THREADS];      // blocks allocated by one thread and released by the next one (maybe on another CPU)
+volatile unsigned int failures;
+volatile unsigned long cpus[THREADS];   // CPUs each thread was seen running on (each thread only writes its own)
+
+char * allocate(unsigned int size, unsigned int seed) {
+    char * b = new char[size];
+    Header * h = reinterpret_cast<Header *>(b);
+    h->size = size;
+    h->seed = seed;
+    for(unsigned int j = sizeof(Header); j < size; j++)
+        b[j] = char(seed + j);
+    return b;
+}
+
+void release(char * b) {
+    Header * h = reinterpret_cast<Header *>(b);
+    for(unsigned int j = sizeof(Header); j < h->size; j++)
+        if(b[j] != char(h->seed + j)) {
+            cout << "Block " << reinterpret_cast<void *>(b) << " (" << h->size << " bytes) was overwritten!" << endl;
+            CPU::finc(failures);
+            break;
+        }
+    delete[] b;
+}
+
+char * swap(char * volatile & slot, char * b) {
+    char * old;
+    do
+        old = slot;
+    while(CPU::cas(slot, old, b) != old);
+    return old;
+}
+
+int worker(unsigned int n)
+{
+    char * block[BLOCKS];
+    unsigned int seed = n * 7919 + 1;
+
+    for(unsigned int r = 0; r < ROUNDS; r++) {
+        cpus[n] |= 1UL << CPU::id();
+
+        for(unsigned int i = 0; i < BLOCKS; i++) {
+            seed = seed * 1103515245 + 12345;
+            block[i] = allocate(sizeof(Header) + (seed >> 16) % MAX_SIZE, seed);
+        }
+
+        // Hand one block over to the next thread and release whatever the previous one left for us
+        char * mine = swap(exchange[n], block[0]);
+        if(mine)
+            release(mine);
+        char * theirs = swap(exchange[(n + THREADS - 1) % THREADS], 0);
+        if(theirs)
+            release(theirs);
+
+        for(unsigned int i = 1; i < BLOCKS; i += 2)
+            release(block[i]);
+        for(unsigned int i = 2; i < BLOCKS; i += 2)
+            release(block[i]);
+
+        if(r % 8 == 0)
+            Thread::yield();
+    }
+
+    cpus[n] |= 1UL << CPU::id();
+
+    return n;
+}
+
+int main()
+{
+    cout << "Per-CPU Heap Caches Test" << endl;
+
+    cout << "\nThis test creates " << THREADS << " threads on " << Traits<Machine>::CPUS << " CPUs, each allocating " << BLOCKS << " blocks of up to " << MAX_SIZE
+         << " bytes, filling" << endl;
+    cout << "them with a pattern and releasing them, " << ROUNDS << " times over. One block per round is released by another" << endl;
+    cout << "thread, thus usually through another CPU's cache. No block may be overwritten while allocated." << endl;
+
+    Thread * thread[THREADS];
+    for(unsigned int i = 0; i < THREADS; i++)
+        thread[i] = new Thread(&worker, i);
+
+    for(unsigned int i = 0; i < THREADS; i++) {
+        thread[i]->join();
+        delete thread[i];
+    }
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        if(exchange[i])
+            release(exchange[i]);
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        cout << "Thread " << i << " ran on CPUs " << hex << cpus[i] << dec << endl;
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+// EPOS High Resolution Alarm Test Program
+
+#include <time.h>
+#include <real-time.h>
+
+using namespace EPOS;
+
+typedef Traits<Thread>::Criterion Criterion;
+
+const Microsecond TICK = 1000000 / Traits<Timer>::FREQUENCY; // scheduling priorities are still kept in these ticks
+const Microsecond TOLERANCE = 1000; // us, still well below a tick
+
+const unsigned int DELAYS = 3;
+const Microsecond delay[DELAYS] = {1500, 2500, 7300}; // us, none of them a multiple of a tick
+
+const unsigned int THREADS = 2;
+const unsigned int iterations = 100;
+const Microsecond period[THREADS] = {3500, 5500}; // us (deadlines are the same)
+const Microsecond wcet[THREADS] = {500, 1000}; // us
+
+int job(unsigned int i);
+
+OStream cout;
+Chronometer chrono;
+Periodic_Thread * thread[THREADS];
+Microsecond created[THREADS]; // when each thread (and thus its alarm) was created
+unsigned int early[THREADS]; // jobs started before their release (each thread only writes its own)
+unsigned int missed[THREADS]; // jobs finished after their deadline
+unsigned int wrong[THREADS]; // jobs whose priority was not an absolute deadline in FREQUENCY ticks
+
+// Ticks of Traits<Timer>::FREQUENCY since the timer was reset, the unit of EDF priorities
+long scheduling_ticks() { return TSC::time_stamp() * Traits<Timer>::FREQUENCY / TSC::frequency(); }
+
+inline void exec(const Microsecond & time)
+{
+    // Delay was not used here to prevent scheduling interference due to blocking
+    for(Microsecond end = chrono.read() + time; end > chrono.read(););
+}
+
+
+int main()
+{
+    cout << "High Resolution Alarm Test" << endl;
+
+    cout << "\nThis test runs with a tickless timer and high resolution alarms (at " << Alarm::frequency() << " Hz), while the scheduler" << endl;
+    cout << "keeps EDF priorities in ticks of " << TICK << "us. First, the main thread delays itself for";
+    for(unsigned int i = 0; i < DELAYS; i++)
+        cout << " " << delay[i] << "us";
+    cout << "," << endl << "each of which must last no less than asked and no more than " << TOLERANCE << "us beyond that. Then it creates" << endl;
+    for(unsigned int i = 0; i < THREADS; i++)
+        cout << "- A thread " << char('A' + i) << " that execs \"" << char('a' + i) << "\" for " << wcet[i] << "us every " << period[i] << "us;" << endl;
+    cout << "Jobs must never start before their release nor finish after their deadline, and the priority of each" << endl;
+    cout << "job must be its absolute deadline in ticks, not in timer counts." << endl;
+
+    unsigned int failures = 0;
+
+    chrono.start();
+
+    for(unsigned int i = 0; i < DELAYS; i++) {
+        Microsecond start = chrono.read();
+        Alarm::delay(delay[i]);
+        Microsecond elapsed = chrono.read() - start;
+        cout << "Alarm::delay(" << delay[i] << ") took " << elapsed << "us" << endl;
+        if((elapsed < delay[i]) || (elapsed > delay[i] + TOLERANCE))
+            failures++;
+    }
+
+    cout << "Threads will now be created and I'll wait for them to finish..." << endl;
+
+    for(unsigned int i = 0; i < THREADS; i++) {
+        created[i] = chrono.read();
+        thread[i] = new Periodic_Thread(RTConf(period[i], 0, 0, 0, iterations, Thread::READY, Criterion(period[i], period[i], wcet[i])), &job, i);
+    }
+
+    int status[THREADS];
+    for(unsigned int i = 0; i < THREADS; i++)
+        status[i] = thread[i]->join();
+
+    chrono.stop();
+
+    cout << "... done!" << endl;
+
+    for(unsigned int i = 0; i < THREADS; i++) {
+        cout << "Thread " << char(status[i]) << ": " << early[i] << " early jobs, " << missed[i] << " missed deadlines and " << wrong[i]
+             << " wrong priorities" << endl;
+        failures += early[i] + missed[i] + wrong[i];
+    }
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        delete thread[i];
+
+    cout << "I'm also done, bye!" << endl;
+
+    return 0;
+}
+
+int job(unsigned int i)
+{
+    // The alarm was created between "created" and the first job, and then goes off exactly every period
+    Microsecond first = chrono.read();
+    long deadline = (period[i] + TICK / 2) / TICK; // relative, in ticks
+    unsigned int n = 0;
+
+    do {
+        Microsecond start = chrono.read();
+        if(start < created[i] + n * period[i])
+            early[i]++;
+
+        // Job 0 runs at creation with its relative deadline, the others are released by the alarm, which sets it
+        // to the absolute one, from the tick that was current then
+        if(n) {
+            long p = int(thread[i]->priority()) - scheduling_ticks();
+            if((p < deadline - 1) || (p > deadline))
+                wrong[i]++;
+        }
+
+        exec(wcet[i]);
+
+        if(chrono.read() > first + (n + 1) * period[i])
+            missed[i]++;
+        n++;
+    } while (Periodic_Thread::wait_next());
+
+    return 'A' + i;
+}
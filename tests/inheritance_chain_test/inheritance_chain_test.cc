@@ -0,0 +1,195 @@
+// EPOS Transitive Priority Inheritance Test Program
+
+#include <time.h>
+#include <synchronizer.h>
+
+using namespace EPOS;
+
+typedef Traits<Thread>::Criterion Criterion;
+typedef Thread::Configuration Configuration;
+
+const int HIGH = 10;
+const int MEDIUM = 20;
+const int LOW = 30;
+const Microsecond STEP = 20000; // us, long enough for every thread to run until it blocks (or spins)
+
+OStream cout;
+Mutex m1;
+Mutex m2;
+volatile bool go;
+volatile bool done_high;
+volatile bool done_medium;
+unsigned int failures;
+
+// Priorities seen by the threads themselves, to be checked by main once they are done
+volatile int p_medium_holding_m2;
+volatile int p_medium_after_m2;
+volatile int p_medium_after_m1;
+volatile int p_low_after_m2;
+volatile int p_first;
+volatile int p_second;
+volatile bool medium_ran_first;
+
+int priority() { return Thread::self()->priority(); }
+
+void check(const char * what, int got, int expected)
+{
+    cout << "  " << what << ": " << got << " (expected " << expected << ")";
+    if(got != expected) {
+        cout << " <= FAILED";
+        failures++;
+    }
+    cout << endl;
+}
+
+
+// Chain: high blocks on m1, held by medium, which is blocked on m2, held by low
+int chain_low()
+{
+    m2.lock();
+    while(!go);
+    m2.unlock();
+    p_low_after_m2 = priority();
+    return 'L';
+}
+
+int chain_medium()
+{
+    m1.lock();
+    m2.lock();
+    p_medium_holding_m2 = priority();
+    m2.unlock();
+    p_medium_after_m2 = priority(); // still inherits from high through m1
+    m1.unlock();
+    p_medium_after_m1 = priority();
+    return 'M';
+}
+
+int chain_high()
+{
+    m1.lock();
+    m1.unlock();
+    return 'H';
+}
+
+void chain()
+{
+    cout << "\nChain: H blocks on M1, held by M, which is blocked on M2, held by L" << endl;
+
+    go = false;
+    Thread * low = new Thread(Configuration(Thread::READY, Criterion(LOW)), &chain_low);
+    Alarm::delay(STEP); // L takes M2
+    Thread * medium = new Thread(Configuration(Thread::READY, Criterion(MEDIUM)), &chain_medium);
+    Alarm::delay(STEP); // M takes M1 and blocks on M2
+    check("p(L) with M waiting for M2", low->priority(), MEDIUM);
+    Thread * high = new Thread(Configuration(Thread::READY, Criterion(HIGH)), &chain_high);
+    Alarm::delay(STEP); // H blocks on M1
+    check("p(M) with H waiting for M1", medium->priority(), HIGH);
+    check("p(L) with H waiting for M1 (through M)", low->priority(), HIGH);
+
+    go = true;
+    high->join();
+    medium->join();
+    low->join();
+
+    check("p(M) holding M1 and M2", p_medium_holding_m2, HIGH);
+    check("p(M) after releasing M2, still holding M1", p_medium_after_m2, HIGH);
+    check("p(M) after releasing M1", p_medium_after_m1, MEDIUM);
+    check("p(L) after releasing M2", p_low_after_m2, LOW);
+
+    delete high;
+    delete medium;
+    delete low;
+}
+
+
+// Two mutexes: low holds both, high waits for m1 and medium for m2, and low releases them in the given order
+int pair_low(bool m1_first)
+{
+    m1.lock();
+    m2.lock();
+    while(!go);
+    if(m1_first) {
+        m1.unlock();
+        p_first = priority(); // high has run by now, but medium still waits for m2
+        medium_ran_first = done_medium;
+        m2.unlock();
+    } else {
+        m2.unlock();
+        p_first = priority(); // still above medium, which must not have run
+        medium_ran_first = done_medium;
+        m1.unlock();
+    }
+    p_second = priority();
+    return 'L';
+}
+
+int pair_medium()
+{
+    m2.lock();
+    done_medium = true;
+    m2.unlock();
+    return 'M';
+}
+
+int pair_high()
+{
+    m1.lock();
+    done_high = true;
+    m1.unlock();
+    return 'H';
+}
+
+void pair(bool m1_first)
+{
+    cout << "\nTwo mutexes: L holds M1 and M2, H waits for M1 and M waits for M2, L releases "
+         << (m1_first ? "M1 and then M2" : "M2 and then M1") << endl;
+
+    go = false;
+    done_high = false;
+    done_medium = false;
+    Thread * low = new Thread(Configuration(Thread::READY, Criterion(LOW)), &pair_low, m1_first);
+    Alarm::delay(STEP); // L takes M1 and M2
+    Thread * medium = new Thread(Configuration(Thread::READY, Criterion(MEDIUM)), &pair_medium);
+    Alarm::delay(STEP); // M blocks on M2 (before H, which would otherwise keep L running above M)
+    Thread * high = new Thread(Configuration(Thread::READY, Criterion(HIGH)), &pair_high);
+    Alarm::delay(STEP); // H blocks on M1
+    check("p(L) with H and M waiting", low->priority(), HIGH);
+
+    go = true;
+    high->join();
+    medium->join();
+    low->join();
+
+    check("p(L) after the first release", p_first, m1_first ? MEDIUM : HIGH);
+    check("M ran before the second release", medium_ran_first, false);
+    check("p(L) after the second release", p_second, LOW);
+    check("H and M got their mutexes", done_high && done_medium, true);
+
+    delete high;
+    delete medium;
+    delete low;
+}
+
+
+int main()
+{
+    cout << "Transitive Priority Inheritance Test" << endl;
+
+    cout << "\nThis test uses three threads, H, M and L, with priorities " << HIGH << ", " << MEDIUM << " and " << LOW << " (the lower, the higher)" << endl;
+    cout << "and two mutexes with priority inheritance. The main thread, above them all, starts each thread and" << endl;
+    cout << "sleeps until it blocks, and then checks the priorities the threads get. A thread must inherit the" << endl;
+    cout << "priority of every thread blocked on it, directly or along a chain of owners, and, when it releases a" << endl;
+    cout << "mutex, keep the highest priority it still inherits through the mutexes it holds." << endl;
+
+    chain();
+    pair(true);
+    pair(false);
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+// EPOS Mailbox Test Program
+
+#include <synchronizer.h>
+#include <process.h>
+
+using namespace EPOS;
+
+const unsigned int SENDERS = 3;
+const unsigned int RECEIVERS = 3;
+const unsigned int MESSAGES = 2000;     // per sender
+const unsigned int SLOTS = 8;           // small, so senders and receivers often have to block
+
+OStream cout;
+
+Mailbox<unsigned int, SLOTS> mpmc;
+Mailbox<unsigned int, SLOTS, true> spsc;
+
+volatile unsigned int received[SENDERS * MESSAGES];
+volatile unsigned int failures;
+
+int mpmc_sender(unsigned int n)
+{
+    for(unsigned int i = 0; i < MESSAGES; i++) {
+        mpmc.send(n * MESSAGES + i);
+        if(i % 64 == 0)
+            Thread::yield();
+    }
+    return n;
+}
+
+// Messages from each sender must get to each receiver in the order they were sent
+int mpmc_receiver(unsigned int n)
+{
+    unsigned int last[SENDERS];
+    bool any[SENDERS];
+    for(unsigned int s = 0; s < SENDERS; s++)
+        any[s] = false;
+
+    for(unsigned int i = 0; i < SENDERS * MESSAGES / RECEIVERS; i++) {
+        unsigned int m = mpmc.receive();
+        unsigned int s = m / MESSAGES;
+        if((s >= SENDERS) || (any[s] && (m <= last[s]))) {
+            CPU::finc(failures);
+            continue;
+        }
+        any[s] = true;
+        last[s] = m;
+        CPU::finc(received[m]);
+    }
+    return n;
+}
+
+int spsc_sender()
+{
+    for(unsigned int i = 0; i < MESSAGES; i++)
+        spsc.send(i);
+    return 0;
+}
+
+int spsc_receiver()
+{
+    for(unsigned int i = 0; i < MESSAGES; i++)
+        if(spsc.receive() != i)
+            CPU::finc(failures);
+    return 0;
+}
+
+int main()
+{
+    cout << "Mailbox Test" << endl;
+
+    cout << "\nThis test first has " << SENDERS << " senders and " << RECEIVERS << " receivers on " << Traits<Machine>::CPUS << " CPUs exchange " << MESSAGES
+         << " messages per sender through" << endl;
+    cout << "a " << SLOTS << "-slot Mailbox over the MPMC ring. Every message must be received exactly once and, by each receiver," << endl;
+    cout << "in the order its sender sent it. Then a single sender and a single receiver exchange " << MESSAGES << " messages" << endl;
+    cout << "through a Mailbox over the SPSC ring, which must all arrive in order." << endl;
+
+    Thread * thread[SENDERS + RECEIVERS];
+    for(unsigned int i = 0; i < RECEIVERS; i++)
+        thread[i] = new Thread(&mpmc_receiver, i);
+    for(unsigned int i = 0; i < SENDERS; i++)
+        thread[RECEIVERS + i] = new Thread(&mpmc_sender, i);
+    for(unsigned int i = 0; i < SENDERS + RECEIVERS; i++) {
+        thread[i]->join();
+        delete thread[i];
+    }
+
+    unsigned int wrong = 0;
+    for(unsigned int i = 0; i < SENDERS * MESSAGES; i++)
+        if(received[i] != 1)
+            wrong++;
+    cout << "\nMPMC: " << wrong << " message(s) lost or duplicated, mailbox " << (mpmc.empty() ? "empty" : "not empty") << endl;
+
+    Thread * receiver = new Thread(&spsc_receiver);
+    Thread * sender = new Thread(&spsc_sender);
+    sender->join();
+    receiver->join();
+    delete sender;
+    delete receiver;
+    cout << "SPSC: mailbox " << (spsc.empty() ? "empty" : "not empty") << endl;
+
+    unsigned int total = failures + wrong + !mpmc.empty() + !spsc.empty();
+    cout << "\n" << (total ? "FAILED" : "passed") << " (" << total << " failures)" << endl;
+    assert(!total);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
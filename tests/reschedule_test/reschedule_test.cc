@@ -0,0 +1,112 @@
+// EPOS Targeted Rescheduling Test Program
+
+#include <machine/ic.h>
+#include <synchronizer.h>
+
+using namespace EPOS;
+
+typedef Traits<Thread>::Criterion Criterion;
+typedef Thread::Configuration Configuration;
+
+const unsigned int CPUS = Traits<Machine>::CPUS;
+const unsigned int BUSY = CPUS - 1;     // threads that keep every CPU but main's busy
+const int WAKER = 10;                   // above every busy thread
+const int BUSY_BASE = 20;               // busy thread i runs at BUSY_BASE + 10 * i, so the last one is the lowest
+const unsigned int ROUNDS = 20;
+
+OStream cout;
+IC::Interrupt_Handler rescheduler;      // the kernel's handler, which counting() forwards to
+volatile unsigned int deliveries[CPUS]; // INT_RESCHEDULER interrupts taken by each CPU
+volatile unsigned int lowest_cpu;       // where the lowest priority busy thread runs
+volatile unsigned int started;
+volatile bool stop;
+
+Semaphore wake(0);
+volatile unsigned int round;            // rounds completed by the woken thread
+volatile unsigned int woken_elsewhere;  // rounds in which it didn't run on lowest_cpu
+
+void counting(IC::Interrupt_Id i)
+{
+    deliveries[CPU::id()]++;
+    rescheduler(i);
+}
+
+int busy(unsigned int i)
+{
+    if(i == BUSY - 1)
+        lowest_cpu = CPU::id();
+    CPU::finc(started);
+    while(!stop);
+    return i;
+}
+
+int woken()
+{
+    for(unsigned int i = 0; i < ROUNDS; i++) {
+        wake.p();
+        if(CPU::id() != lowest_cpu)
+            woken_elsewhere++;
+        round = i + 1;
+    }
+    return 'W';
+}
+
+int main()
+{
+    cout << "Targeted Rescheduling Test" << endl;
+
+    cout << "\nThis test keeps the " << CPUS << " CPUs busy, one with the main thread and the others with " << BUSY << " threads of decreasing" << endl;
+    cout << "priority (" << BUSY_BASE << ", " << BUSY_BASE + 10 << ", ...). Then main wakes a thread of priority " << WAKER << " up " << ROUNDS
+         << " times. Each time, only the CPU running the" << endl;
+    cout << "lowest priority thread may be preempted, so it must be the only one to get an INT_RESCHEDULER, and" << endl;
+    cout << "the woken thread must run there. Interrupts are counted by a handler that wraps the kernel's." << endl;
+
+    rescheduler = IC::int_vector(IC::INT_RESCHEDULER);
+    IC::int_vector(IC::INT_RESCHEDULER, &counting);
+
+    Thread * w = new Thread(Configuration(Thread::READY, Criterion(WAKER)), &woken); // blocks on wake right away
+    Thread * thread[BUSY];
+    for(unsigned int i = 0; i < BUSY; i++)
+        thread[i] = new Thread(Configuration(Thread::READY, Criterion(int(BUSY_BASE + 10 * i))), &busy, i);
+    while(started < BUSY);
+
+    unsigned int before[CPUS];
+    for(unsigned int i = 0; i < CPUS; i++)
+        before[i] = deliveries[i];
+
+    for(unsigned int i = 0; i < ROUNDS; i++) {
+        wake.v();
+        while(round <= i);
+    }
+
+    unsigned int failures = woken_elsewhere;
+    cout << "\nThe lowest priority busy thread runs on CPU " << lowest_cpu << endl;
+    for(unsigned int i = 0; i < CPUS; i++) {
+        unsigned int got = deliveries[i] - before[i];
+        unsigned int expected = (i == lowest_cpu) ? ROUNDS : 0;
+        cout << "CPU " << i << ": " << got << " INT_RESCHEDULER (expected " << expected << ")";
+        if(got != expected) {
+            cout << " <= FAILED";
+            failures++;
+        }
+        cout << endl;
+    }
+    cout << "Rounds in which the woken thread ran elsewhere: " << woken_elsewhere << endl;
+
+    stop = true;
+    w->join();
+    delete w;
+    for(unsigned int i = 0; i < BUSY; i++) {
+        thread[i]->join();
+        delete thread[i];
+    }
+
+    IC::int_vector(IC::INT_RESCHEDULER, rescheduler);
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+// EPOS Reader-Writer Lock and Sequence Lock Test Program
+
+#include <time.h>
+#include <synchronizer.h>
+#include <process.h>
+
+using namespace EPOS;
+
+const unsigned int READERS = 6;
+const unsigned int WRITERS = 2;
+const unsigned int ITERATIONS = 200;
+const unsigned int WORDS = 16;
+
+OStream cout;
+
+RW_Lock rw_lock;
+Seqlock seqlock;
+
+volatile unsigned long data[WORDS];     // every write sets all words to the same new value
+volatile unsigned int readers_inside;
+volatile unsigned int writers_inside;
+volatile unsigned int max_readers;      // the most readers seen inside at once
+volatile unsigned int retries;          // sequence lock reads done again because a writer got in
+volatile unsigned int failures;
+
+void write(unsigned long v) {
+    for(unsigned int i = 0; i < WORDS; i++) {
+        data[i] = v;
+        for(volatile unsigned int j = 0; j < 64; j++); // widen the window for readers to see a partial write
+    }
+}
+
+bool consistent(const volatile unsigned long * d) {
+    for(unsigned int i = 1; i < WORDS; i++)
+        if(d[i] != d[0])
+            return false;
+    return true;
+}
+
+int rw_reader()
+{
+    for(unsigned int i = 0; i < ITERATIONS; i++) {
+        rw_lock.lock_read();
+        unsigned int inside = CPU::finc(readers_inside) + 1;
+        for(unsigned int m = max_readers; inside > m; m = max_readers)
+            CPU::cas(max_readers, m, inside);
+        if(writers_inside || !consistent(data))
+            CPU::finc(failures);
+        Alarm::delay(500);
+        if(writers_inside || !consistent(data))
+            CPU::finc(failures);
+        CPU::fdec(readers_inside);
+        rw_lock.unlock_read();
+    }
+    return 0;
+}
+
+int rw_writer()
+{
+    for(unsigned int i = 0; i < ITERATIONS; i++) {
+        rw_lock.lock_write();
+        if((CPU::finc(writers_inside) != 0) || readers_inside)
+            CPU::finc(failures);
+        write(data[0] + 1);
+        if(readers_inside)
+            CPU::finc(failures);
+        CPU::fdec(writers_inside);
+        rw_lock.unlock_write();
+        Alarm::delay(1000);
+    }
+    return 0;
+}
+
+int seq_reader()
+{
+    unsigned long copy[WORDS];
+    for(unsigned int i = 0; i < ITERATIONS * 10; i++) {
+        unsigned long s;
+        bool first = true;
+        do {
+            if(!first)
+                CPU::finc(retries);
+            first = false;
+            s = seqlock.read_begin();
+            for(unsigned int j = 0; j < WORDS; j++)
+                copy[j] = data[j];
+        } while(seqlock.read_retry(s));
+        if(!consistent(copy))
+            CPU::finc(failures);
+    }
+    return 0;
+}
+
+int seq_writer()
+{
+    for(unsigned int i = 0; i < ITERATIONS; i++) {
+        seqlock.write_lock();
+        if(CPU::finc(writers_inside) != 0)
+            CPU::finc(failures);
+        write(data[0] + 1);
+        CPU::fdec(writers_inside);
+        seqlock.write_unlock();
+        Alarm::delay(500);
+    }
+    return 0;
+}
+
+unsigned int run(const char * name, int (* reader)(), int (* writer)())
+{
+    for(unsigned int i = 0; i < WORDS; i++)
+        data[i] = 0;
+    failures = 0;
+
+    Thread * thread[READERS + WRITERS];
+    for(unsigned int i = 0; i < READERS + WRITERS; i++)
+        thread[i] = new Thread((i < READERS) ? reader : writer);
+    for(unsigned int i = 0; i < READERS + WRITERS; i++) {
+        thread[i]->join();
+        delete thread[i];
+    }
+
+    // Each write adds one to the data, so none may have been lost
+    if(data[0] != WRITERS * ITERATIONS)
+        failures++;
+
+    cout << name << ": " << data[0] << " writes (expected " << WRITERS * ITERATIONS << ") => " << (failures ? "FAILED" : "passed")
+         << " (" << failures << " failures)" << endl;
+
+    return failures;
+}
+
+int main()
+{
+    cout << "Reader-Writer Lock and Sequence Lock Test" << endl;
+
+    cout << "\nThis test creates " << READERS << " readers and " << WRITERS << " writers on " << Traits<Machine>::CPUS << " CPUs sharing " << WORDS
+         << " words, which every write" << endl;
+    cout << "sets to the same new value. With the RW_Lock, readers must never see a writer inside nor inconsistent" << endl;
+    cout << "words, and more than one reader must get in at once. With the Seqlock, every snapshot a reader keeps must be" << endl;
+    cout << "consistent. Either way, no write may be lost." << endl << endl;
+
+    unsigned int total = 0;
+
+    total += run("RW_Lock", &rw_reader, &rw_writer);
+    cout << "Up to " << max_readers << " readers held the RW_Lock at once" << endl;
+    if(max_readers < 2)
+        total++;
+
+    total += run("Seqlock", &seq_reader, &seq_writer);
+    cout << "Readers retried " << retries << " times" << endl;
+
+    cout << "\n" << (total ? "FAILED" : "passed") << " (" << total << " failures)" << endl;
+    assert(!total);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
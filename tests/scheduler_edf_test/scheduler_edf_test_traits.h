@@ -118,6 +118,7 @@ template<> struct Traits<Thread>: public Traits<Build>
     static const bool simulate_capacity = false;
 
     typedef EDF Criterion;
+    static const int scheduling_queue = Scheduling_Queue_Backend::PAIRING_HEAP;
     static const unsigned int QUANTUM = 10000; // us
 };
 
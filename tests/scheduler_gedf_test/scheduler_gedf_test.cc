@@ -0,0 +1,111 @@
+// EPOS Global EDF Scheduler Test Program
+
+#include <time.h>
+#include <real-time.h>
+
+using namespace EPOS;
+
+typedef Traits<Thread>::Criterion Criterion;
+
+const unsigned int THREADS = 4;
+const unsigned int iterations = 50;
+const unsigned int period[THREADS] = {100, 80, 60, 50}; // ms
+const unsigned int wcet[THREADS] = {40, 30, 20, 10}; // ms
+const unsigned long affinity[THREADS] = {0x3, 0x6, ~0UL, 0x8}; // CPUs 0-1, CPUs 1-2, any CPU and CPU 3
+const unsigned int cpu[THREADS] = {Criterion::ANY, Criterion::ANY, Criterion::ANY, 3}; // D gets its CPU at construction
+
+int job(unsigned int i);
+
+OStream cout;
+Chronometer chrono;
+Periodic_Thread * thread[THREADS];
+volatile unsigned int misplaced; // samples of a thread running on a CPU out of its affinity mask
+unsigned int moves[THREADS]; // CPU changes seen by each thread while running its jobs
+
+inline void exec(char c, unsigned int i, unsigned int time = 0) // in miliseconds
+{
+    // Delay was not used here to prevent scheduling interference due to blocking
+    Microsecond elapsed = chrono.read() / 1000;
+    unsigned int last_cpu = CPU::id();
+
+    cout << "\n" << elapsed << "\t" << c << "@" << last_cpu;
+
+    for(Microsecond end = elapsed + time, last = elapsed; end > elapsed; elapsed = chrono.read() / 1000) {
+        unsigned int now_cpu = CPU::id();
+        if(!(affinity[i] & (1UL << now_cpu)))
+            CPU::finc(misplaced);
+        if(now_cpu != last_cpu) {
+            moves[i]++;
+            last_cpu = now_cpu;
+        }
+        if(last != elapsed) {
+            cout << "\n" << elapsed << "\t" << c << "@" << now_cpu;
+            last = elapsed;
+        }
+    }
+}
+
+
+int main()
+{
+    cout << "Global EDF Scheduler Test" << endl;
+
+    cout << "\nThis test consists in creating " << THREADS << " periodic threads, A to D, that busy wait for a while in each job:" << endl;
+    for(unsigned int i = 0; i < THREADS; i++)
+        cout << "- Every " << period[i] << "ms, thread " << char('A' + i) << " execs \"" << char('a' + i) << "\" for "
+             << wcet[i] << "ms, on CPUs " << hex << affinity[i] << dec << " (affinity mask);" << endl;
+    cout << "Each \"x@n\" line shows the CPU a thread runs on, which must be in its mask. Every change of CPU a thread" << endl;
+    cout << "sees must also have been counted as a migration by the scheduler and thread D, bound to a single CPU, must" << endl;
+    cout << "not migrate at all." << endl;
+
+    cout << "Threads will now be created and I'll wait for them to finish..." << endl;
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        thread[i] = new Periodic_Thread(RTConf(period[i] * 1000, 0, 0, 0, iterations, Thread::READY,
+                                               Criterion(period[i] * 1000, Criterion::SAME, Criterion::UNKNOWN, cpu[i])), &job, i);
+
+    chrono.start();
+
+    int status[THREADS];
+    for(unsigned int i = 0; i < THREADS; i++)
+        status[i] = thread[i]->join();
+
+    chrono.stop();
+
+    cout << "\n... done!" << endl;
+
+    unsigned int failures = misplaced;
+    for(unsigned int i = 0; i < THREADS; i++) {
+        const volatile Criterion::Statistics & s = thread[i]->statistics();
+        cout << "Thread " << char(status[i]) << " migrated " << s.migrations << " times (" << moves[i]
+             << " seen) and last ran on CPU " << s.last_cpu << endl;
+        if((s.migrations < moves[i]) || !(affinity[i] & (1UL << s.last_cpu)))
+            failures++;
+    }
+    if(thread[THREADS - 1]->statistics().migrations)
+        failures++;
+
+    cout << "\nSamples out of the affinity masks: " << misplaced << endl;
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        delete thread[i];
+
+    cout << "I'm also done, bye!" << endl;
+
+    return 0;
+}
+
+int job(unsigned int i)
+{
+    // A thread restricts itself to its CPUs, moving to one of them right away if needed
+    if(cpu[i] == Criterion::ANY)
+        Thread::self()->affinity(affinity[i]);
+
+    do {
+        exec('a' + i, i, wcet[i]);
+    } while (Periodic_Thread::wait_next());
+
+    return 'A' + i;
+}
@@ -118,6 +118,7 @@ template<> struct Traits<Thread>: public Traits<Build>
     static const bool simulate_capacity = false;
 
     typedef RM Criterion;
+    static const int scheduling_queue = Scheduling_Queue_Backend::LEVEL_BITMAP;
     static const unsigned int QUANTUM = 10000; // us
 };
 
@@ -0,0 +1,116 @@
+// EPOS Semi-partitioned EDF Scheduler Test Program
+
+#include <time.h>
+#include <real-time.h>
+
+using namespace EPOS;
+
+typedef Traits<Thread>::Criterion Criterion;
+
+const unsigned int THREADS = 5;
+const unsigned int CPUS = Traits<Machine>::CPUS;
+const unsigned int iterations = 50;
+const unsigned int period = 100; // ms (the same for all threads)
+const unsigned int wcet[THREADS] = {70, 60, 50, 45, 60}; // ms, in decreasing utilization order but for E, which doesn't fit in any CPU
+
+int job(unsigned int i);
+
+OStream cout;
+Chronometer chrono;
+Periodic_Thread * thread[THREADS];
+unsigned int samples[THREADS][CPUS]; // how many times each thread was seen running on each CPU (each thread only writes its own row)
+
+inline void exec(char c, unsigned int i, unsigned int time = 0) // in miliseconds
+{
+    // Delay was not used here to prevent scheduling interference due to blocking
+    Microsecond elapsed = chrono.read() / 1000;
+
+    cout << "\n" << elapsed << "\t" << c << "@" << CPU::id();
+
+    for(Microsecond end = elapsed + time, last = elapsed; end > elapsed; elapsed = chrono.read() / 1000) {
+        samples[i][CPU::id()]++;
+        if(last != elapsed) {
+            cout << "\n" << elapsed << "\t" << c << "@" << CPU::id();
+            last = elapsed;
+        }
+    }
+}
+
+
+int main()
+{
+    cout << "Semi-partitioned EDF Scheduler Test" << endl;
+
+    cout << "\nThis test consists in creating " << THREADS << " periodic threads, A to E, that busy wait for a while in each job:" << endl;
+    for(unsigned int i = 0; i < THREADS; i++)
+        cout << "- Every " << period << "ms, thread " << char('A' + i) << " execs \"" << char('a' + i) << "\" for " << wcet[i] << "ms;" << endl;
+    cout << "A to D fill " << CPUS << " CPUs up to 70%, 60%, 50% and 45%, so E (60%) must be split between CPUs 0 (30%) and" << endl;
+    cout << "1 (the other 30%). Each \"x@n\" line shows the CPU a thread runs on: A to D must stay on their own CPUs and E" << endl;
+    cout << "must run on both of its CPUs and nowhere else. Once all threads are gone, the CPUs must be free again." << endl;
+
+    cout << "Threads will now be created and I'll wait for them to finish..." << endl;
+
+    unsigned int failures = 0;
+    for(unsigned int i = 0; i < THREADS; i++) {
+        Criterion c(period * 1000, period * 1000, wcet[i] * 1000);
+        cout << "Thread " << char('A' + i) << ": CPU " << c.first();
+        if(c.split())
+            cout << " and then CPU " << c.second();
+        cout << endl;
+
+        if(i < THREADS - 1) {
+            if(c.split() || (c.first() != i))
+                failures++;
+        } else if(!c.split() || (c.first() != 0) || (c.second() != 1))
+            failures++;
+
+        thread[i] = new Periodic_Thread(RTConf(period * 1000, 0, 0, 0, iterations, Thread::READY, c), &job, i);
+    }
+
+    chrono.start();
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        thread[i]->join();
+
+    chrono.stop();
+
+    cout << "\n... done!" << endl;
+
+    for(unsigned int i = 0; i < THREADS; i++) {
+        cout << "Thread " << char('A' + i) << " ran on CPUs";
+        for(unsigned int cpu = 0; cpu < CPUS; cpu++) {
+            if(samples[i][cpu])
+                cout << " " << cpu;
+            bool expected = (i < THREADS - 1) ? (cpu == i) : (cpu <= 1);
+            if(expected != bool(samples[i][cpu]))
+                failures++;
+        }
+        cout << endl;
+    }
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        delete thread[i];
+
+    // All shares were given back, so a thread as heavy as A fits in the first CPU again
+    Criterion c(period * 1000, period * 1000, wcet[0] * 1000);
+    cout << "\nA new thread like A would now go to CPU " << c.first() << endl;
+    if(c.split() || (c.first() != 0))
+        failures++;
+    c.retire();
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm also done, bye!" << endl;
+
+    return 0;
+}
+
+int job(unsigned int i)
+{
+    do {
+        exec('a' + i, i, wcet[i]);
+    } while (Periodic_Thread::wait_next());
+
+    return 'A' + i;
+}
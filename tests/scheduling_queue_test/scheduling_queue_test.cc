@@ -0,0 +1,159 @@
+// EPOS Scheduling Queue Backends Test Program
+
+#include <utility/ostream.h>
+#include <utility/list.h>
+
+using namespace EPOS;
+
+const unsigned int JOBS = 64;
+const unsigned int OPERATIONS = 4000;
+const unsigned int BATCH = 8;           // elements merged at once (e.g. waiters released by a broadcast)
+
+OStream cout;
+
+struct Job {
+    bool pending;
+    unsigned int seq;                   // insertion order, which breaks ties among equal ranks
+};
+
+Job job[JOBS];
+unsigned int seq;
+
+unsigned int seed = 3;
+unsigned int pseudo_random() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7fff; }
+
+// Plenty of ties, a few negative ranks (e.g. MAIN) and ranks spread over many bit lengths (i.e. bitmap levels)
+int pseudo_random_rank() { return (pseudo_random() % 8 == 0) ? -1 : int(pseudo_random() % 8) << (pseudo_random() % 24); }
+
+// The pending element that must leave the queue next: the lowest rank and, among those, the first inserted
+template<typename Element>
+Element * expected(Element ** link) {
+    Element * e = 0;
+    for(unsigned int i = 0; i < JOBS; i++)
+        if(job[i].pending && (!e || (link[i]->rank() < e->rank()) || ((link[i]->rank() == e->rank()) && (job[i].seq < e->object()->seq))))
+            e = link[i];
+    return e;
+}
+
+template<typename Element>
+Element * pick(Element ** link, bool pending) {
+    unsigned int i = pseudo_random() % JOBS;
+    for(unsigned int n = 0; n < JOBS; n++, i = (i + 1) % JOBS)
+        if(job[i].pending == pending)
+            return link[i];
+    return 0;
+}
+
+// Runs random inserts, removals of the head and of arbitrary elements, and merges of ordered batches (as
+// Thread::wakeup_all() does with a waiting queue) on "L", checking every removal against a plain linear search
+template<typename L>
+unsigned int test(const char * name)
+{
+    typedef typename L::Element Element;
+
+    L queue;
+    Ordered_List<Job, int, Element> waiting;
+    Element * link[JOBS];
+    unsigned int failures = 0;
+    unsigned int pending = 0;
+
+    for(unsigned int i = 0; i < JOBS; i++) {
+        job[i].pending = false;
+        link[i] = new Element(&job[i]);
+    }
+
+    for(unsigned int n = 0; n < OPERATIONS; n++) {
+        unsigned int op = pseudo_random() % 8;
+        if(op < 3) { // insert
+            Element * e = pick(link, false);
+            if(!e)
+                continue;
+            e->rank(pseudo_random_rank());
+            e->object()->pending = true;
+            e->object()->seq = seq++;
+            queue.insert(e);
+            pending++;
+        } else if(op < 5) { // remove the head
+            Element * e = expected(link);
+            Element * r = queue.remove();
+            if(r != e) {
+                cout << "  " << name << ": removed " << r << " instead of " << e << "!" << endl;
+                failures++;
+            }
+            if(r) {
+                r->object()->pending = false;
+                pending--;
+            }
+        } else if(op < 7) { // remove an arbitrary element
+            Element * e = pick(link, true);
+            if(!e)
+                continue;
+            if(queue.remove(e) != e) {
+                cout << "  " << name << ": couldn't remove " << e << "!" << endl;
+                failures++;
+            }
+            e->object()->pending = false;
+            pending--;
+        } else { // merge an ordered batch
+            for(unsigned int i = 0; i < BATCH; i++) {
+                Element * e = pick(link, false);
+                if(!e)
+                    break;
+                e->rank(pseudo_random_rank());
+                e->object()->pending = true;
+                e->object()->seq = seq++;
+                waiting.insert(e);
+                pending++;
+            }
+            queue.merge(&waiting);
+            if(!waiting.empty()) {
+                cout << "  " << name << ": merge() left elements behind!" << endl;
+                failures++;
+            }
+        }
+
+        if(queue.size() != pending) {
+            cout << "  " << name << ": size is " << queue.size() << " instead of " << pending << "!" << endl;
+            failures++;
+        }
+        if(queue.head() != expected(link)) {
+            cout << "  " << name << ": head is " << queue.head() << " instead of " << expected(link) << "!" << endl;
+            failures++;
+        }
+    }
+
+    while(!queue.empty()) {
+        Element * e = expected(link);
+        if(queue.remove() != e)
+            failures++;
+        e->object()->pending = false;
+    }
+
+    for(unsigned int i = 0; i < JOBS; i++)
+        delete link[i];
+
+    cout << name << ": " << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+
+    return failures;
+}
+
+int main()
+{
+    cout << "Scheduling Queue Backends Test" << endl;
+
+    cout << "\nThis test runs " << OPERATIONS << " random operations (insert, remove the head, remove any element, and merge" << endl;
+    cout << "a batch of up to " << BATCH << " elements from an ordered waiting list) on each container a scheduling queue may" << endl;
+    cout << "use. Every head must be the element with the lowest rank and, among equal ranks, the first inserted." << endl << endl;
+
+    unsigned int failures = 0;
+    failures += test<Ordered_List<Job, int, List_Elements::Doubly_Linked_Scheduling<Job, int>>>("Ordered_List");
+    failures += test<Pairing_Heap<Job, int>>("Pairing_Heap");
+    failures += test<Bitmap_Ordered_List<Job, int>>("Bitmap_Ordered_List");
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+// EPOS Ticket Spin Lock Test Program
+
+#include <utility/spin.h>
+#include <process.h>
+
+using namespace EPOS;
+
+const unsigned int THREADS = 8;
+const unsigned int ITERATIONS = 20000;
+
+OStream cout;
+
+Spin spin;
+Simple_Spin simple_spin;
+
+volatile unsigned int inside;           // threads inside the critical section (must never be more than one)
+volatile unsigned int overlaps;
+unsigned long counter;                  // incremented without atomics, so any overlap loses updates
+
+void increment() {
+    if(CPU::finc(inside) != 0)
+        CPU::finc(overlaps);
+    unsigned long c = counter;
+    for(volatile unsigned int i = 0; i < 8; i++); // widen the window for lost updates
+    counter = c + 1;
+    CPU::fdec(inside);
+}
+
+// Interrupts are disabled while holding a lock, as the kernel does (see Thread::lock()), so a thread is never
+// preempted inside the critical section and the others only spin for as long as it takes to increment the counter
+int recursive(unsigned int n)
+{
+    for(unsigned int i = 0; i < ITERATIONS; i++) {
+        CPU::int_disable();
+        spin.acquire();
+        if(i % 16 == 0) { // the owner may acquire a Spin again without deadlocking
+            spin.acquire();
+            increment();
+            spin.release();
+        } else
+            increment();
+        spin.release();
+        CPU::int_enable();
+    }
+    return n;
+}
+
+int flat(unsigned int n)
+{
+    for(unsigned int i = 0; i < ITERATIONS; i++) {
+        CPU::int_disable();
+        simple_spin.acquire();
+        increment();
+        simple_spin.release();
+        CPU::int_enable();
+    }
+    return n;
+}
+
+unsigned int run(const char * name, int (* entry)(unsigned int))
+{
+    counter = 0;
+    overlaps = 0;
+
+    Thread * thread[THREADS];
+    for(unsigned int i = 0; i < THREADS; i++)
+        thread[i] = new Thread(entry, i);
+    for(unsigned int i = 0; i < THREADS; i++) {
+        thread[i]->join();
+        delete thread[i];
+    }
+
+    unsigned int failures = overlaps + (counter != THREADS * ITERATIONS);
+    cout << name << ": counter = " << counter << " (expected " << THREADS * ITERATIONS << "), overlaps = " << overlaps
+         << " => " << (failures ? "FAILED" : "passed") << endl;
+
+    return failures;
+}
+
+int main()
+{
+    cout << "Ticket Spin Lock Test" << endl;
+
+    cout << "\nThis test creates " << THREADS << " threads on " << Traits<Machine>::CPUS << " CPUs that increment a shared counter " << ITERATIONS
+         << " times each inside" << endl;
+    cout << "a critical section guarded by a ticket spin lock, first a recursive Spin (taken twice every now and then)" << endl;
+    cout << "and then a Simple_Spin. No two threads may ever be inside the critical section at once, thus no" << endl;
+    cout << "increment may be lost. The kernel's own locks are ticket locks too in this configuration." << endl << endl;
+
+    unsigned int failures = 0;
+    failures += run("Spin", &recursive);
+    failures += run("Simple_Spin", &flat);
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
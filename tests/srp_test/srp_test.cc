@@ -0,0 +1,167 @@
+// EPOS Per-Mutex Ceilings and Stack Resource Policy Test Program
+
+#include <time.h>
+#include <synchronizer.h>
+
+using namespace EPOS;
+
+typedef Traits<Thread>::Criterion Criterion;
+typedef Thread::Configuration Configuration;
+
+const int URGENT = 5;   // uses no mutex
+const int HIGH = 10;    // uses X
+const int MEDIUM = 20;  // uses Y
+const int LOW = 30;     // uses X and Y
+const Microsecond STEP = 20000; // us, long enough for every ready thread to run until it is done (or spins)
+
+OStream cout;
+Mutex x;                                // ceiling given by its registered users (H and L)
+Mutex y((Criterion(MEDIUM)));           // ceiling declared at construction
+Thread * volatile holder[2];            // threads inside X and Y
+volatile bool go;
+volatile bool inside;                   // L is inside its critical sections
+volatile unsigned int blocked;          // lock()s that found the mutex taken (and would block)
+unsigned int failures;
+
+volatile bool urgent_ran;               // ... while L was inside
+volatile bool high_ran;
+volatile bool medium_ran;
+volatile int p_low_inside;
+volatile bool medium_ran_inside_x;      // ... after L left Y, but still inside X
+
+int priority() { return Thread::self()->priority(); }
+
+void check(const char * what, int got, int expected)
+{
+    cout << "  " << what << ": " << got << " (expected " << expected << ")";
+    if(got != expected) {
+        cout << " <= FAILED";
+        failures++;
+    }
+    cout << endl;
+}
+
+void enter(Mutex * m, unsigned int i)
+{
+    if(holder[i])
+        blocked++;
+    m->lock();
+    holder[i] = Thread::self();
+}
+
+void leave(Mutex * m, unsigned int i)
+{
+    holder[i] = 0;
+    m->unlock();
+}
+
+
+int urgent()
+{
+    urgent_ran = inside;
+    return 'U';
+}
+
+// H only uses X, so in the first part it is unrelated to what L holds
+int high()
+{
+    high_ran = inside;
+    enter(&x, 0);
+    leave(&x, 0);
+    return 'H';
+}
+
+int medium()
+{
+    medium_ran = inside;
+    enter(&y, 1);
+    leave(&y, 1);
+    return 'M';
+}
+
+// L holds Y (part 1) or X and then Y (part 2) until main says go
+int low(bool both)
+{
+    if(both)
+        enter(&x, 0);
+    enter(&y, 1);
+    inside = true;
+    p_low_inside = priority();
+    while(!go);
+    inside = false;
+    leave(&y, 1);
+    if(both) {
+        medium_ran_inside_x = medium_ran;
+        leave(&x, 0);
+    }
+    return 'L';
+}
+
+void run(bool both)
+{
+    go = false;
+    inside = false;
+    urgent_ran = high_ran = medium_ran = medium_ran_inside_x = false;
+
+    Thread * l = new Thread(Configuration(Thread::SUSPENDED, Criterion(LOW)), &low, both);
+    Thread * u = new Thread(Configuration(Thread::SUSPENDED, Criterion(URGENT)), &urgent);
+    Thread * h = new Thread(Configuration(Thread::SUSPENDED, Criterion(HIGH)), &high);
+    Thread * m = new Thread(Configuration(Thread::SUSPENDED, Criterion(MEDIUM)), &medium);
+
+    // Users must be registered before any of them acquires the mutex
+    x.register_user(h);
+    x.register_user(l);
+
+    l->resume();
+    Alarm::delay(STEP); // L enters its critical section(s)
+    u->resume();
+    h->resume();
+    m->resume();
+    Alarm::delay(STEP); // whoever can preempt L runs now
+
+    go = true;
+    u->join();
+    h->join();
+    m->join();
+    l->join();
+
+    delete u;
+    delete h;
+    delete m;
+    delete l;
+}
+
+
+int main()
+{
+    cout << "Per-Mutex Ceilings and Stack Resource Policy Test" << endl;
+
+    cout << "\nThis test runs, on a single CPU under SRP, a thread L (priority " << LOW << ") that uses mutexes X and Y, a thread" << endl;
+    cout << "M (" << MEDIUM << ") that uses Y, a thread H (" << HIGH << ") that uses X and a thread U (" << URGENT << ") that uses none of them. Y has its" << endl;
+    cout << "ceiling declared (" << MEDIUM << ") and X gets it from its registered users (" << HIGH << "). The others are released while L" << endl;
+    cout << "is inside its critical sections. Only threads above the ceilings of the mutexes L holds may start" << endl;
+    cout << "before L leaves them, and no thread may ever find a mutex taken once it has started." << endl;
+
+    cout << "\nL holds Y only: U and H, unrelated to Y, must preempt it, while M must wait" << endl;
+    run(false);
+    check("p(L) inside Y", p_low_inside, MEDIUM);
+    check("U ran while L was inside", urgent_ran, true);
+    check("H ran while L was inside", high_ran, true);
+    check("M ran while L was inside", medium_ran, false);
+
+    cout << "\nL holds X and Y: only U may preempt it, and M can't start until L leaves X either" << endl;
+    run(true);
+    check("p(L) inside X and Y", p_low_inside, HIGH);
+    check("U ran while L was inside", urgent_ran, true);
+    check("H ran while L was inside", high_ran, false);
+    check("M ran after L left Y, inside X", medium_ran_inside_x, false);
+
+    check("\nlock()s that found the mutex taken", blocked, 0);
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+// EPOS Tickless Timer Test Program
+
+#include <time.h>
+#include <real-time.h>
+
+using namespace EPOS;
+
+typedef Traits<Thread>::Criterion Criterion;
+
+const unsigned int THREADS = 3;
+const unsigned int iterations = 30;
+const unsigned int period[THREADS] = {40, 60, 120}; // ms (all released together every 120 ms)
+const unsigned int wcet[THREADS] = {10, 15, 20}; // ms
+const Microsecond TICK = 1000000 / Traits<Timer>::FREQUENCY; // alarms are still counted in FREQUENCY ticks
+const Microsecond TOLERANCE = TICK / 2; // how late a job may start after its release
+
+int job(unsigned int i);
+
+OStream cout;
+Chronometer chrono;
+Periodic_Thread * thread[THREADS];
+long worst[THREADS]; // latest start of a job relative to its release, in us (each thread only writes its own)
+unsigned int late[THREADS];
+unsigned int early[THREADS];
+
+inline void exec(unsigned int time) // in miliseconds
+{
+    // Delay was not used here to prevent scheduling interference due to blocking
+    Microsecond elapsed = chrono.read() / 1000;
+
+    for(Microsecond end = elapsed + time; end > elapsed; elapsed = chrono.read() / 1000);
+}
+
+
+int main()
+{
+    cout << "Tickless Timer Test" << endl;
+
+    cout << "\nThis test consists in creating " << THREADS << " periodic LLF threads on " << Traits<Machine>::CPUS << " CPUs with a tickless timer:" << endl;
+    for(unsigned int i = 0; i < THREADS; i++)
+        cout << "- Every " << period[i] << "ms, thread " << char('A' + i) << " execs \"" << char('a' + i) << "\" for " << wcet[i] << "ms;" << endl;
+    cout << "There is always at least one idle CPU, whose timer is stopped, and the main thread sleeps on join()," << endl;
+    cout << "so CPU 0, which handles the alarms, only wakes up when the next job is due. All threads are released" << endl;
+    cout << "by the same interrupt every " << period[THREADS - 1] << "ms. Each job must start no later than " << TOLERANCE << "us after its release" << endl;
+    cout << "and never before it (alarms are counted in ticks of " << TICK << "us, so a release happens up to a tick before the time" << endl;
+    cout << "computed from the first job)." << endl;
+
+    cout << "Threads will now be created and I'll wait for them to finish..." << endl;
+
+    chrono.start();
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        thread[i] = new Periodic_Thread(RTConf(period[i] * 1000, 0, 0, 0, iterations, Thread::READY, Criterion(period[i] * 1000, wcet[i] * 1000)), &job, i);
+
+    int status[THREADS];
+    for(unsigned int i = 0; i < THREADS; i++)
+        status[i] = thread[i]->join();
+
+    chrono.stop();
+
+    cout << "\n... done!" << endl;
+
+    unsigned int failures = 0;
+    for(unsigned int i = 0; i < THREADS; i++) {
+        cout << "Thread " << char(status[i]) << ": latest start " << worst[i] << "us after release, " << late[i] << " late and "
+             << early[i] << " early jobs" << endl;
+        failures += late[i] + early[i];
+    }
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    for(unsigned int i = 0; i < THREADS; i++)
+        delete thread[i];
+
+    cout << "I'm also done, bye!" << endl;
+
+    return 0;
+}
+
+int job(unsigned int i)
+{
+    Microsecond first = chrono.read();
+    unsigned int n = 0;
+
+    do {
+        // Job n is released n periods after the first one started, give or take a tick
+        Microsecond start = chrono.read();
+        long lateness = long(start) - long(first + n * period[i] * 1000);
+        if(lateness > worst[i])
+            worst[i] = lateness;
+        if(lateness > long(TOLERANCE))
+            late[i]++;
+        if(lateness < -long(TICK + TOLERANCE))
+            early[i]++;
+
+        cout << "\n" << start / 1000 << "\t" << char('a' + i) << "@" << CPU::id() << " (" << lateness << "us)";
+
+        exec(wcet[i]);
+        n++;
+    } while (Periodic_Thread::wait_next());
+
+    return 'A' + i;
+}
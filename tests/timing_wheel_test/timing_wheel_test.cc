@@ -0,0 +1,132 @@
+// EPOS Timing Wheel Test Program
+
+#include <utility/wheel.h>
+#include <time.h>
+
+using namespace EPOS;
+
+const unsigned int EVENTS = 200;
+const long HORIZON = 1000;      // events are due from 1 to HORIZON
+const long MAX_STEP = 40;       // time advances by 1 to MAX_STEP at a time
+
+// A small wheel (8 slots in 2 levels), so most events go through cascades and the overflow list
+struct Event;
+typedef List_Elements::Doubly_Linked_Ordered<Event, long> Element;
+typedef Timing_Wheel<Event, long, Element, 3, 2> Wheel;
+
+struct Event {
+    Event(): link(this) {}
+
+    long due;
+    bool pending;
+    bool cancelled;
+    Element link;
+};
+
+OStream cout;
+Wheel wheel;
+Event event[EVENTS];
+unsigned int failures;
+
+unsigned int seed = 7;
+unsigned int pseudo_random() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7fff; }
+
+const unsigned int ALARMS = 3;
+const unsigned int period[ALARMS] = {10000, 20000, 30000}; // us
+const unsigned int times[ALARMS] = {5, 7, 9};
+volatile unsigned int count[ALARMS];
+
+void tick_a() { count[0]++; }
+void tick_b() { count[1]++; }
+void tick_c() { count[2]++; }
+
+void fail(const char * what, unsigned int i, long now) {
+    cout << "  event " << i << " (due at " << event[i].due << ") " << what << " at " << now << "!" << endl;
+    failures++;
+}
+
+int main()
+{
+    cout << "Timing Wheel Test" << endl;
+
+    cout << "\nThis test inserts " << EVENTS << " events due from 1 to " << HORIZON << " in a timing wheel with 8 slots in 2 levels" << endl;
+    cout << "(so most go through cascades and the overflow list), cancels some of them and advances time in" << endl;
+    cout << "random steps. Every event that isn't cancelled must expire exactly once, in the first step that" << endl;
+    cout << "reaches it, and next() must never be later than the earliest pending event." << endl;
+
+    for(unsigned int i = 0; i < EVENTS; i++) {
+        event[i].due = 1 + pseudo_random() % HORIZON;
+        event[i].pending = true;
+        event[i].cancelled = false;
+        event[i].link.rank(event[i].due);
+        wheel.insert(&event[i].link);
+    }
+
+    for(unsigned int i = 0; i < EVENTS; i += 5) {
+        if(wheel.remove(&event[i].link) != &event[i].link)
+            fail("could not be cancelled", i, wheel.now());
+        event[i].pending = false;
+        event[i].cancelled = true;
+    }
+
+    long last = wheel.now();
+    while(!wheel.empty()) {
+        long earliest = HORIZON + 1;
+        for(unsigned int i = 0; i < EVENTS; i++)
+            if(event[i].pending && (event[i].due < earliest))
+                earliest = event[i].due;
+        if(wheel.next() > earliest) {
+            cout << "  next() is " << wheel.next() << ", but an event is due at " << earliest << "!" << endl;
+            failures++;
+        }
+
+        long now = last + 1 + pseudo_random() % MAX_STEP;
+        wheel.advance(now);
+
+        for(Element * e = wheel.remove_expired(); e; e = wheel.remove_expired()) {
+            unsigned int i = e->object() - event;
+            if(!event[i].pending)
+                fail(event[i].cancelled ? "expired after being cancelled" : "expired twice", i, now);
+            else if((event[i].due > now) || (event[i].due <= last))
+                fail("expired", i, now);
+            event[i].pending = false;
+        }
+
+        for(unsigned int i = 0; i < EVENTS; i++)
+            if(event[i].pending && (event[i].due <= now))
+                fail("hasn't expired", i, now);
+
+        last = now;
+    }
+
+    for(unsigned int i = 0; i < EVENTS; i++)
+        if(event[i].pending)
+            fail("was lost", i, last);
+
+    cout << "Wheel drained at " << last << " with " << failures << " failure(s)" << endl;
+
+    cout << "\nNow creating " << ALARMS << " alarms with periods of " << period[0] / 1000 << ", " << period[1] / 1000 << " and "
+         << period[2] / 1000 << " ms, to go off " << times[0] << ", " << times[1] << " and " << times[2] << " times ..." << endl;
+
+    Function_Handler handler_a(&tick_a);
+    Function_Handler handler_b(&tick_b);
+    Function_Handler handler_c(&tick_c);
+    Alarm alarm_a(period[0], &handler_a, times[0]);
+    Alarm alarm_b(period[1], &handler_b, times[1]);
+    Alarm alarm_c(period[2], &handler_c, times[2]);
+
+    Alarm::delay(period[2] * (times[2] + 2));
+
+    for(unsigned int i = 0; i < ALARMS; i++) {
+        cout << "Alarm " << i << " went off " << count[i] << " times" << endl;
+        if(count[i] != times[i])
+            failures++;
+    }
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}
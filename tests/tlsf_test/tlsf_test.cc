@@ -0,0 +1,119 @@
+// EPOS TLSF Heap Test Program
+
+#include <utility/ostream.h>
+#include <utility/heap.h>
+
+using namespace EPOS;
+
+const unsigned int BLOCKS = 64;
+const unsigned int MAX_SIZE = 2000; // bytes
+const unsigned int ROUNDS = 8;
+const unsigned int POOL_SIZE = 256 * 1024;
+
+OStream cout;
+
+char pool[POOL_SIZE] __attribute__((aligned(16)));
+TLSF_Heap heap(pool, sizeof(pool));
+
+char * block[BLOCKS];
+unsigned int size[BLOCKS];
+unsigned int failures;
+
+unsigned int seed = 1;
+unsigned int pseudo_random() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7fff; }
+
+void fill(unsigned int i) {
+    for(unsigned int j = 0; j < size[i]; j++)
+        block[i][j] = char(i + j);
+}
+
+bool check(unsigned int i) {
+    for(unsigned int j = 0; j < size[i]; j++)
+        if(block[i][j] != char(i + j))
+            return false;
+    return true;
+}
+
+void release(unsigned int i) {
+    if(!check(i)) {
+        cout << "  block " << i << " (" << size[i] << " bytes) was overwritten!" << endl;
+        failures++;
+    }
+    TLSF_Heap::untyped_free(&heap, block[i]);
+    block[i] = 0;
+}
+
+int main()
+{
+    cout << "TLSF Heap Test" << endl;
+
+    cout << "\nThis test allocates " << BLOCKS << " blocks of 1 to " << MAX_SIZE << " bytes from a private TLSF heap, fills them" << endl;
+    cout << "with a pattern and releases them in a different order (odd ones first), " << ROUNDS << " times over." << endl;
+    cout << "Each block must keep its pattern until released and, once all are released, the heap must be back to" << endl;
+    cout << "a single free block of its original size (i.e. every release coalesced with its neighbours)." << endl;
+
+    unsigned long initial = heap.grouped_size();
+    cout << "\nInitial heap: " << heap.size() << " free block(s), " << initial << " bytes" << endl;
+
+    for(unsigned int r = 0; r < ROUNDS; r++) {
+        for(unsigned int i = 0; i < BLOCKS; i++) {
+            size[i] = 1 + pseudo_random() % MAX_SIZE;
+            block[i] = reinterpret_cast<char *>(heap.alloc(size[i]));
+            if(!block[i]) {
+                cout << "  round " << r << ": allocation of " << size[i] << " bytes failed!" << endl;
+                failures++;
+                size[i] = 0;
+                continue;
+            }
+            fill(i);
+        }
+
+        // Release a few in the middle and reuse the holes with different sizes
+        for(unsigned int i = r % 4; i < BLOCKS; i += 4)
+            if(block[i])
+                release(i);
+        for(unsigned int i = r % 4; i < BLOCKS; i += 4) {
+            size[i] = 1 + pseudo_random() % (MAX_SIZE / 4);
+            block[i] = reinterpret_cast<char *>(heap.alloc(size[i]));
+            if(block[i])
+                fill(i);
+        }
+
+        for(unsigned int i = 1; i < BLOCKS; i += 2)
+            if(block[i])
+                release(i);
+        for(unsigned int i = 0; i < BLOCKS; i += 2)
+            if(block[i])
+                release(i);
+
+        cout << "Round " << r << ": " << heap.size() << " free block(s), " << heap.grouped_size() << " bytes" << endl;
+        if((heap.size() != 1) || (heap.grouped_size() != initial)) {
+            cout << "  the heap didn't coalesce back into its original block!" << endl;
+            failures++;
+        }
+    }
+
+    cout << "\nNow allocating and releasing mixed sizes from the system heap (which is also a TLSF_Heap here) ..." << endl;
+    for(unsigned int r = 0; r < ROUNDS; r++) {
+        for(unsigned int i = 0; i < BLOCKS; i++) {
+            size[i] = 1 + pseudo_random() % MAX_SIZE;
+            block[i] = new char[size[i]];
+            fill(i);
+        }
+        for(unsigned int i = 0; i < BLOCKS; i++) {
+            unsigned int j = (i * 7) % BLOCKS; // 7 and BLOCKS are coprime, so this visits every block once
+            if(!check(j)) {
+                cout << "  block " << j << " (" << size[j] << " bytes) was overwritten!" << endl;
+                failures++;
+            }
+            delete[] block[j];
+        }
+    }
+
+    cout << "\n" << (failures ? "FAILED" : "passed") << " (" << failures << " failures)" << endl;
+    assert(!failures);
+
+    cout << "I'm done, bye!" << endl;
+
+    return 0;
+}